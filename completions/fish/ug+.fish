@@ -12,6 +12,7 @@ complete -c ug+ -l bool -s '%' -o '%%' -d 'Specifies Boolean query patterns'
 complete -c ug+ -l break -d 'Adds a line break between results from different files'
 complete -c ug+ -s C -l context -d 'Output NUM lines of leading and trailing context surrounding each matching line'
 complete -c ug+ -s c -l count -d 'Only a count of selected lines is written to standard output'
+complete -c ug+ -r -l cache -d 'Skip files that did not match the same search before and did not change since, as recorded in the cache FILE'
 complete -c ug+ -l color -l colour -d 'Mark up the matching text with the colors specified with option --colors or the GREP_COLOR or GREP_COLORS environment variable'
 complete -c ug+ -l colors -l colours -d 'Use COLORS to mark up text'
 complete -c ug+ -l config -l - -d 'Use configuration FILE'
@@ -24,6 +25,7 @@ complete -c ug+ -s d -l directories -xa 'read recurse skip' -d 'If an input file
 complete -c ug+ -l delay -d 'Set the default -Q key response delay'
 complete -c ug+ -l depth -s 1 -s 2 -s 3 -s 9 -o '10' -o '11' -d 'Restrict recursive searches from MIN to MAX directory levels deep, where -1 (--depth=1) searches the specified path without recursing into subdirectories'
 complete -c ug+ -l dotall -d 'Dot . in regular expressions matches anything, including newline.'
+complete -c ug+ -l drop-cache -d 'Drop pages of files read that were not cached before from the page cache'
 complete -c ug+ -s E -l extended-regexp -d 'Interpret patterns as extended regular expressions (EREs)'
 complete -c ug+ -s e -r -l regexp -d 'Specify a PATTERN to search the input'
 complete -c ug+ -l encoding -xa 'binary ASCII UTF-8 UTF-16 UTF-16BE UTF-16LE UTF-32 UTF-32BE UTF-32LE LATIN1 ISO-8859-1 ISO-8859-2 ISO-8859-3 ISO-8859-4 ISO-8859-5 ISO-8859-6 ISO-8859-7 ISO-8859-8 ISO-8859-9 ISO-8859-10 ISO-8859-11 ISO-8859-13 ISO-8859-14 ISO-8859-15 ISO-8859-16 MAC MACROMAN EBCDIC CP437 CP850 CP858 CP1250 CP1251 CP1252 CP1253 CP1254 CP1255 CP1256 CP1257 CP1258 KOI8-R KOI8-U KOI8-RU null-data ' -d 'The encoding format of the input'
@@ -93,6 +95,8 @@ complete -c ug+ -s Q -l query -d 'Query mode: start a TUI to perform interactive
 complete -c ug+ -s q -l quiet -l silent -d 'Quiet mode: suppress all output'
 complete -c ug+ -s R -l dereference-recursive -d 'Recursively read all files under each directory, following symbolic links to files and directories, unlike -r'
 complete -c ug+ -s r -l recursive -d 'Recursively read all files under each directory, following symbolic links only if they are on the command line'
+complete -c ug+ -l read-order -xa 'inode extent size' -d 'Search the files in a directory in the ORDER they are stored'
+complete -c ug+ -l records -d 'Output file matches as compact binary records'
 complete -c ug+ -l replace -d 'Replace matching patterns in the output by FORMAT with % fields'
 complete -c ug+ -s S -l dereference-files -d 'When -r is specified, follow symbolic links to files, but not to directories'
 complete -c ug+ -s s -l no-messages -d 'Silent mode: nonexistent and unreadable files are ignored and their error messages and warnings are suppressed'
@@ -100,11 +104,13 @@ complete -c ug+ -l save-config -d 'Save configuration FILE to include OPTIONS'
 complete -c ug+ -l separator -l context-separator -d 'Use SEP as field separator between file name, line number, column number, byte offset and the matched line'
 complete -c ug+ -l split -d 'Split the -Q query TUI screen on startup'
 complete -c ug+ -l sort -xa 'name best size changed created used rname rbest rsize rchanged rcreated rused' -d 'Displays matching files in the order specified by KEY in recursive searches'
-complete -c ug+ -l stats -d 'Output statistics on the number of files and directories searched and the inclusion and exclusion constraints applied'
+complete -c ug+ -l sort-buffer -d 'When sorting with --sort, output not yet due is held in memory up to SIZE bytes, then in a temporary file'
+complete -c ug+ -l stats -xa 'phases json vm' -d 'Output statistics on the number of files and directories searched and the inclusion and exclusion constraints applied'
 complete -c ug+ -s T -l initial-tab -d 'Add a tab space to separate the file name, line number, column number and byte offset with the matched line'
 complete -c ug+ -s t -l file-type -xa 'actionscript ada adoc asm asp aspx autoconf automake awk Awk basic batch bison c c++ clojure cpp csharp css csv dart Dart delphi elisp elixir erlang fortran gif Gif go groovy gsp haskell html jade java jpeg Jpeg js json jsp julia kotlin less lex lisp lua m4 make markdown matlab node Node objc objc++ ocaml parrot pascal pdf Pdf perl Perl php Php png Png prolog python Python r rpm Rpm rst rtf Rtf ruby Ruby rust scala scheme seed7 shell Shell smalltalk sql svg swift tcl tex text tiff Tiff tt typescript verilog vhdl vim xml Xml yacc yaml zig ' -d 'Search only files associated with TYPES, a comma-separated list of file types'
 complete -c ug+ -l tabs -d 'Set the tab size to NUM to expand tabs for option -k'
 complete -c ug+ -l tag -d 'Disables colors to mark up matches with TAG'
+complete -c ug+ -r -l trace -d 'Record a timeline of the search in FILE in the Chrome trace event JSON format'
 complete -c ug+ -l tree -s '^' -d 'Output directories with matching files in a tree-like format for option -c or --count, -l or --files-with-matches, -L or --files-without-match'
 complete -c ug+ -s U -l ascii -l binary -d 'Disables Unicode matching for ASCII and binary matching'
 complete -c ug+ -s u -l ungroup -d 'Do not group multiple pattern matches on the same matched line'
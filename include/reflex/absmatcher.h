@@ -162,6 +162,11 @@ class AbstractMatcher {
     virtual void operator()(AbstractMatcher&, const char*, size_t, size_t) = 0;
     virtual ~Handler() { };
   };
+  /// Window functor base class to slide a window over input data that is accessed in place, e.g. memory-mapped input, returns pointer to the data at input offset off and sets size to the number of bytes available (at least len bytes unless EOF), or returns NULL on failure.
+  struct Window {
+    virtual char *operator()(size_t off, size_t len, size_t& size) = 0;
+    virtual ~Window() { };
+  };
  protected:
   /// AbstractMatcher::Options for matcher engines.
   struct Option {
@@ -435,6 +440,7 @@ class AbstractMatcher {
     bol_ = buf_;
     evh_ = NULL;
 #endif
+    win_ = NULL;
     lpb_ = buf_;
     lno_ = 1;
 #if WITH_SPAN
@@ -537,6 +543,12 @@ class AbstractMatcher {
       char  *s, ///< points to the string buffer to fill with input
       size_t n) ///< size of buffer pointed to by s
   {
+    if (win_ != NULL)
+    {
+      // the window data is already in place, the window ends at max_ - 1
+      size_t k = buf_ + max_ - 1 - s;
+      return n < k ? n : k;
+    }
     return in.get(s, n);
   }
   /// Returns true if wrapping of input after EOF is supported.
@@ -590,6 +602,7 @@ class AbstractMatcher {
       bol_ = buf_;
       evh_ = NULL;
 #endif
+      win_ = NULL;
       lpb_ = buf_;
       lno_ = 1;
 #if WITH_SPAN
@@ -605,6 +618,21 @@ class AbstractMatcher {
     }
     return *this;
   }
+  /// Set the buffer base to the initial window of size bytes of character data to scan in place (data is not modified), the window slides over the input with the window functor when more input is needed, reset/restart the matcher.
+  AbstractMatcher& window(
+      Window *window, ///< window functor to slide the window
+      char *base,     ///< base of the initial window
+      size_t size)    ///< nonzero size of the initial window, base[size] must be readable
+    /// @returns this matcher
+  {
+    if (window != NULL && size > 0)
+    {
+      buffer(base, size + 1);
+      win_ = window;
+      eof_ = false;
+    }
+    return *this;
+  }
   /// Returns nonzero capture index (i.e. true) if the entire input matches this matcher's pattern (and internally caches the true/false result to permit repeat invocations).
   inline size_t matches()
     /// @returns nonzero capture index if the entire input matched this matcher's pattern, zero (i.e. false) otherwise
@@ -1515,6 +1543,17 @@ class AbstractMatcher {
       bol_ = txt_;
     }
     size_t gap = bol_ - buf_;
+    if (win_ != NULL)
+    {
+      // keep reserved bytes before the current line in the window, when nonzero (default is zero)
+      gap = gap > res_ ? gap - res_ : 0;
+      // invoke user-defined handler when defined
+      if (gap > 0)
+        handle(gap);
+      slide(gap, need);
+      cpb_ = bol_;
+      return true;
+    }
     if (gap > res_)
     {
       // keep reserved bytes before the current line in the buffer, when nonzero (default is zero)
@@ -1569,6 +1608,12 @@ class AbstractMatcher {
     cpb_ = bol_;
 #else
     size_t gap = txt_ - buf_;
+    if (win_ != NULL)
+    {
+      (void)lineno();
+      slide(gap, need);
+      return true;
+    }
     if (max_ - end_ + gap >= need)
     {
       DBGLOG("Shift buffer to close gap of %zu bytes", gap);
@@ -1620,6 +1665,27 @@ class AbstractMatcher {
 #endif
     return true;
   }
+  /// Slide the window over the input to shift gap bytes out and to make room for need bytes, change cur_, pos_, end_, max_, ind_, buf_, bol_, lpb_, and txt_.
+  inline void slide(size_t gap, size_t need)
+  {
+    size_t size = 0;
+    char *newbuf = (*win_)(num_ + gap, end_ - gap + need + 1, size);
+    if (newbuf == NULL)
+      throw std::bad_alloc();
+    DBGLOG("Slide window to close gap of %zu bytes", gap);
+    cur_ -= gap;
+    ind_ -= gap;
+    pos_ -= gap;
+    end_ -= gap;
+    num_ += gap;
+    txt_ = newbuf + (txt_ - buf_ - gap);
+#if WITH_SPAN
+    bol_ = newbuf + (bol_ - buf_ - gap);
+#endif
+    lpb_ = newbuf + (lpb_ - buf_ - gap);
+    buf_ = newbuf;
+    max_ = size + 1;
+  }
   /// Returns the next character read from the current input source.
   inline int get()
     /// @returns the character read (unsigned char 0..255) or EOF (-1)
@@ -1732,6 +1798,7 @@ class AbstractMatcher {
   const char *bol_; ///< begin of line pointer in buffer
   Handler    *evh_; ///< event handler functor to invoke when buffer contents are shifted out
 #endif
+  Window     *win_; ///< window functor to slide the window over the input when the buffer is a window, or NULL
   const char *lpb_; ///< line pointer in buffer, updated when counting line numbers with lineno()
   size_t      lno_; ///< line number count (cached)
 #if WITH_SPAN
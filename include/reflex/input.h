@@ -779,6 +779,23 @@ class Input {
       char  *s, ///< points to the string buffer to fill with input
       size_t n) ///< size of buffer pointed to by s
       ;
+  /// Called by file_get() to read and transcode blocks of UTF-16 input to UTF-8, advances t and decreases n by the number of bytes stored.
+  void file_get_utf16(
+      char  *&t, ///< points to the string buffer to fill with input
+      size_t& n, ///< size of buffer pointed to by t
+      bool   be) ///< big endian UTF-16
+      ;
+  /// Called by file_get() to read and transcode blocks of UTF-32 input to UTF-8, advances t and decreases n by the number of bytes stored.
+  void file_get_utf32(
+      char  *&t, ///< points to the string buffer to fill with input
+      size_t& n, ///< size of buffer pointed to by t
+      bool   be) ///< big endian UTF-32
+      ;
+  /// Called by file_get() to read and transcode blocks of latin-1 or code page input to UTF-8, advances t and decreases n by the number of bytes stored.
+  void file_get_page(
+      char  *&t, ///< points to the string buffer to fill with input
+      size_t& n) ///< size of buffer pointed to by t
+      ;
   /// Read n bytes into buffer s from file, block when IO is non-blocking, return false when fewer bytes read on failure or eof.
   bool file_read(
       char  *s, ///< points to the string buffer to file with input
@@ -41,6 +41,13 @@
 #include <reflex/pattern.h>
 #include <stack>
 
+// set the advance FIND function pointer of a Matcher and its name when compiled with -DWITH_MATCHER_STATS
+#if defined(WITH_MATCHER_STATS)
+# define REFLEX_INIT_ADVANCE(method) (adv_ = &Matcher::method, adv_name_ = #method)
+#else
+# define REFLEX_INIT_ADVANCE(method) (adv_ = &Matcher::method)
+#endif
+
 namespace reflex {
 
 /// RE/flex matcher engine class, implements reflex::PatternMatcher pattern matching interface with scan, find, split functors and iterators.
@@ -186,6 +193,33 @@ class Matcher : public PatternMatcher<reflex::Pattern> {
     tab_.resize(0);
     init_advance();
   }
+#if defined(WITH_MATCHER_STATS)
+  /// Counters of the search method to advance to a possible match with find(), accumulated until cleared (compiled with -DWITH_MATCHER_STATS).
+  struct Counters {
+    Counters() : skipped(0), candidates(0), verified(0), matches(0) { }
+    size_t skipped;    ///< number of bytes skipped by the search method
+    size_t candidates; ///< number of possible match positions found by the search method
+    size_t verified;   ///< number of possible match positions found by the search method that were verified by the DFA or by the string comparison of a one string match
+    size_t matches;    ///< number of matches found
+  };
+  /// Returns the name of the search method selected for the pattern to advance to a possible match with find().
+  const char *advance_method() const
+    /// @returns name of the advance method
+  {
+    return adv_name_;
+  }
+  /// Returns the search method counters accumulated so far.
+  const Counters& counters() const
+    /// @returns reference to the counters
+  {
+    return ctr_;
+  }
+  /// Clear the search method counters.
+  void clear_counters()
+  {
+    ctr_ = Counters();
+  }
+#endif
   /// Returns captured text as a std::pair<const char*,size_t> with string pointer (non-0-terminated) and length.
   virtual std::pair<const char*,size_t> operator[](size_t n) const REFLEX_OVERRIDE
   {
@@ -1333,6 +1367,23 @@ class Matcher : public PatternMatcher<reflex::Pattern> {
   size_t simd_match_avx512bw(Method method);
   /// match() with optimized AVX2 string search scheme defined in matcher_avx2.cpp
   size_t simd_match_avx2(Method method);
+  /// Advance the engine to a possible match at or after loc with the search method selected by init_advance().
+  inline bool advance(size_t loc)
+    /// @returns true if a possible match was found
+  {
+#if defined(WITH_MATCHER_STATS)
+    size_t from = num_ + loc;
+    bool found = (this->*adv_)(loc);
+    size_t to = num_ + cur_;
+    if (to > from)
+      ctr_.skipped += to - from;
+    if (found)
+      ++ctr_.candidates;
+    return found;
+#else
+    return (this->*adv_)(loc);
+#endif
+  }
   /// Initialize specialized (+ SSE2/NEON) pattern search methods to advance the engine to a possible match
   void init_advance();
   /// Initialize specialized AVX2 pattern search methods to advance the engine to a possible match
@@ -1452,6 +1503,10 @@ class Matcher : public PatternMatcher<reflex::Pattern> {
   std::stack<Stops> stk_; ///< stack to push/pop stops
   FSM               fsm_; ///< local state for FSM code
   bool (Matcher::*  adv_)(size_t loc); ///< advance FIND function pointer
+#if defined(WITH_MATCHER_STATS)
+  const char       *adv_name_; ///< name of the advance FIND function
+  Counters          ctr_; ///< advance FIND counters
+#endif
   bool              mrk_; ///< indent \i or dedent \j in pattern found: should check and update indent stops
 };
 
@@ -149,6 +149,14 @@ extern size_t simd_nlcount_avx512bw(const char *& b, const char *e);
 // Partially check if valid UTF-8 encoding
 extern bool simd_isutf8_avx2(const char *& b, const char *e);
 
+// Partially find the first byte to escape, a control character below the given bound other than except or one of five bytes
+extern const char *simd_find_escape_avx2(const char *s, const char *e, uint8_t below, uint8_t except, const char chars[5]);
+
+// Partially copy leading ASCII bytes, narrow leading ASCII UTF-16 and UTF-32 code units, returns the number of bytes or code units
+extern size_t simd_copy_ascii_avx2(const char *s, size_t n, char *t);
+extern size_t simd_narrow_utf16_avx2(const char *s, size_t n, char *t, bool be);
+extern size_t simd_narrow_utf32_avx2(const char *s, size_t n, char *t, bool be);
+
 } // namespace reflex
 
 #elif defined(HAVE_NEON)
@@ -175,6 +183,18 @@ extern size_t nlcount(const char *s, const char *e);
 /// Check if valid UTF-8 encoding and does not include a NUL, but accept surrogates and 3/4 byte overlongs
 extern bool isutf8(const char *s, const char *e);
 
+/// Find the first byte in string s up to e to escape, a control character below the given bound other than except or one of the five bytes in chars, returns e when not found
+extern const char *find_escape(const char *s, const char *e, uint8_t below, uint8_t except, const char chars[5]);
+
+/// Copy the leading ASCII bytes of string s of n bytes to t, returns the number of bytes copied
+extern size_t copy_ascii(const char *s, size_t n, char *t);
+
+/// Narrow the leading ASCII UTF-16 code units of string s of n code units to bytes in t, big endian when be is true, returns the number of code units narrowed
+extern size_t narrow_utf16(const char *s, size_t n, char *t, bool be);
+
+/// Narrow the leading ASCII UTF-32 code units of string s of n code units to bytes in t, big endian when be is true, returns the number of code units narrowed
+extern size_t narrow_utf32(const char *s, size_t n, char *t, bool be);
+
 } // namespace reflex
 
 #endif
@@ -35,6 +35,7 @@
 */
 
 #include <reflex/input.h>
+#include <reflex/simd.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -745,6 +746,175 @@ void Input::file_init()
   }
 }
 
+// the size of the blocks of UTF-16, UTF-32, latin-1 and code page input read by file_get() to transcode to UTF-8, 32K blocks keep the transcoded UTF-8 in cache for the matcher while amortizing the read() calls
+#ifndef REFLEX_FILE_BLOCK
+# define REFLEX_FILE_BLOCK 32768
+#endif
+
+// the maximum number of UTF-8 bytes of a transcoded UTF-16 code unit, including a surrogate pair completed at the end of a block
+static const size_t utf16_max = sizeof(REFLEX_NONCHAR_UTF8) - 1 > 4 ? sizeof(REFLEX_NONCHAR_UTF8) - 1 : 4;
+
+// the maximum number of UTF-8 bytes of a transcoded UTF-32 code unit
+static const size_t utf32_max = 6;
+
+// decode a UTF-16 code unit
+static inline int utf16_unit(const char *s, bool be)
+{
+  const unsigned char *u = reinterpret_cast<const unsigned char*>(s);
+  return be ? u[0] << 8 | u[1] : u[0] | u[1] << 8;
+}
+
+void Input::file_get_utf16(char *& t, size_t& n, bool be)
+{
+  char block[REFLEX_FILE_BLOCK];
+  // transcode blocks while at least 16 code units fit, leave the rest to file_get() to transcode per code unit
+  while (n / utf16_max >= 16)
+  {
+    size_t k = n / utf16_max;
+    if (k > sizeof(block) / 2)
+      k = sizeof(block) / 2;
+    size_t m = ::fread(block, 1, 2 * k, file_);
+    // complete a partial code unit using a blocking read, drop it at EOF
+    if ((m & 1) != 0)
+    {
+      if (file_read(block + m, 1))
+        ++m;
+      else
+        --m;
+    }
+    const char *b = block;
+    const char *e = block + (m & ~static_cast<size_t>(1));
+    char *r = t;
+    while (b < e)
+    {
+      // narrow ASCII runs with SIMD
+      size_t a = narrow_utf16(b, (e - b) / 2, t, be);
+      b += 2 * a;
+      t += a;
+      if (b >= e)
+        break;
+      int c = utf16_unit(b, be);
+      b += 2;
+      if (c >= 0xD800 && c < 0xE000)
+      {
+        // UTF-16 surrogate pair, complete the pair using a blocking read when the pair is split across blocks
+        char pair[2];
+        const char *p = NULL;
+        if (c < 0xDC00)
+        {
+          if (b < e)
+          {
+            p = b;
+            b += 2;
+          }
+          else if (file_read(pair, 2))
+          {
+            p = pair;
+          }
+        }
+        if (p != NULL && (utf16_unit(p, be) & 0xFC00) == 0xDC00)
+          c = 0x010000 - 0xDC00 + ((c - 0xD800) << 10) + utf16_unit(p, be);
+        else
+          c = REFLEX_NONCHAR;
+      }
+      t += utf8(c, t);
+    }
+    n -= t - r;
+    // stop when no more input is available or at EOF
+    if (m < 2 * k)
+      break;
+  }
+}
+
+void Input::file_get_utf32(char *& t, size_t& n, bool be)
+{
+  char block[REFLEX_FILE_BLOCK];
+  // transcode blocks while at least 16 code units fit, leave the rest to file_get() to transcode per code unit
+  while (n / utf32_max >= 16)
+  {
+    size_t k = n / utf32_max;
+    if (k > sizeof(block) / 4)
+      k = sizeof(block) / 4;
+    size_t m = ::fread(block, 1, 4 * k, file_);
+    // complete a partial code unit using a blocking read, drop it at EOF
+    if ((m & 3) != 0)
+    {
+      if (file_read(block + m, 4 - (m & 3)))
+        m += 4 - (m & 3);
+      else
+        m &= ~static_cast<size_t>(3);
+    }
+    const char *b = block;
+    const char *e = block + m;
+    char *r = t;
+    while (b < e)
+    {
+      // narrow ASCII runs with SIMD
+      size_t a = narrow_utf32(b, (e - b) / 4, t, be);
+      b += 4 * a;
+      t += a;
+      if (b >= e)
+        break;
+      const unsigned char *u = reinterpret_cast<const unsigned char*>(b);
+      int c = be ? u[0] << 24 | u[1] << 16 | u[2] << 8 | u[3] : u[0] | u[1] << 8 | u[2] << 16 | u[3] << 24;
+      b += 4;
+      if (c < 0x80)
+        *t++ = static_cast<char>(c);
+      else
+        t += utf8(c, t);
+    }
+    n -= t - r;
+    // stop when no more input is available or at EOF
+    if (m < 4 * k)
+      break;
+  }
+}
+
+void Input::file_get_page(char *& t, size_t& n)
+{
+  char block[REFLEX_FILE_BLOCK];
+  // transcode blocks while at least 16 bytes fit, leave the rest to file_get() to transcode per byte
+  while (n / 3 >= 16)
+  {
+    size_t k = n / 3;
+    if (k > sizeof(block))
+      k = sizeof(block);
+    size_t m = ::fread(block, 1, k, file_);
+    const char *b = block;
+    const char *e = block + m;
+    char *r = t;
+    if (utfx_ == file_encoding::latin)
+    {
+      while (b < e)
+      {
+        // copy ASCII runs with SIMD
+        size_t a = copy_ascii(b, e - b, t);
+        b += a;
+        t += a;
+        if (b >= e)
+          break;
+        t += utf8(static_cast<unsigned char>(*b++), t);
+      }
+    }
+    else
+    {
+      // translate with the code page table
+      while (b < e)
+      {
+        int c = page_[static_cast<unsigned char>(*b++)];
+        if (c < 0x80)
+          *t++ = static_cast<char>(c);
+        else
+          t += utf8(c, t);
+      }
+    }
+    n -= t - r;
+    // stop when no more input is available or at EOF
+    if (m < k)
+      break;
+  }
+}
+
 size_t Input::file_get(char *s, size_t n)
 {
   char *t = s;
@@ -768,6 +938,7 @@ size_t Input::file_get(char *s, size_t n)
   switch (utfx_)
   {
     case file_encoding::utf16be:
+      file_get_utf16(t, n, true);
       while (n > 0 && ::fread(buf, 1, 1, file_) == 1 && file_read(reinterpret_cast<char*>(buf) + 1, 1))
       {
         int c = buf[0] << 8 | buf[1];
@@ -791,7 +962,7 @@ size_t Input::file_get(char *s, size_t n)
           {
             std::memcpy(t, utf8_, n);
             uidx_ = static_cast<unsigned short>(n);
-            ulen_ = static_cast<unsigned short>(l);
+            ulen_ = static_cast<unsigned short>(l - n);
             t += n;
             n = 0;
           }
@@ -807,6 +978,7 @@ size_t Input::file_get(char *s, size_t n)
         size_ -= t - s;
       return t - s;
     case file_encoding::utf16le:
+      file_get_utf16(t, n, false);
       while (n > 0 && ::fread(buf, 1, 1, file_) == 1 && file_read(reinterpret_cast<char*>(buf) + 1, 1))
       {
         int c = buf[0] | buf[1] << 8;
@@ -830,7 +1002,7 @@ size_t Input::file_get(char *s, size_t n)
           {
             std::memcpy(t, utf8_, n);
             uidx_ = static_cast<unsigned short>(n);
-            ulen_ = static_cast<unsigned short>(l);
+            ulen_ = static_cast<unsigned short>(l - n);
             t += n;
             n = 0;
           }
@@ -846,6 +1018,7 @@ size_t Input::file_get(char *s, size_t n)
         size_ -= t - s;
       return t - s;
     case file_encoding::utf32be:
+      file_get_utf32(t, n, true);
       while (n > 0 && ::fread(buf, 1, 1, file_) == 1 && file_read(reinterpret_cast<char*>(buf) + 1, 3))
       {
         int c = buf[0] << 24 | buf[1] << 16 | buf[2] << 8 | buf[3];
@@ -861,7 +1034,7 @@ size_t Input::file_get(char *s, size_t n)
           {
             std::memcpy(t, utf8_, n);
             uidx_ = static_cast<unsigned short>(n);
-            ulen_ = static_cast<unsigned short>(l);
+            ulen_ = static_cast<unsigned short>(l - n);
             t += n;
             n = 0;
           }
@@ -877,6 +1050,7 @@ size_t Input::file_get(char *s, size_t n)
         size_ -= t - s;
       return t - s;
     case file_encoding::utf32le:
+      file_get_utf32(t, n, false);
       while (n > 0 && ::fread(buf, 1, 1, file_) == 1 && file_read(reinterpret_cast<char*>(buf) + 1, 3))
       {
         int c = buf[0] | buf[1] << 8 | buf[2] << 16 | buf[3] << 24;
@@ -892,7 +1066,7 @@ size_t Input::file_get(char *s, size_t n)
           {
             std::memcpy(t, utf8_, n);
             uidx_ = static_cast<unsigned short>(n);
-            ulen_ = static_cast<unsigned short>(l);
+            ulen_ = static_cast<unsigned short>(l - n);
             t += n;
             n = 0;
           }
@@ -908,6 +1082,7 @@ size_t Input::file_get(char *s, size_t n)
         size_ -= t - s;
       return t - s;
     case file_encoding::latin:
+      file_get_page(t, n);
       while (n > 0 && ::fread(t, 1, 1, file_) == 1)
       {
         int c = static_cast<unsigned char>(*t);
@@ -929,7 +1104,7 @@ size_t Input::file_get(char *s, size_t n)
           else
           {
             uidx_ = 1;
-            ulen_ = 2;
+            ulen_ = 1;
           }
         }
       }
@@ -968,6 +1143,7 @@ size_t Input::file_get(char *s, size_t n)
     case file_encoding::koi8_u:
     case file_encoding::koi8_ru:
     case file_encoding::custom:
+      file_get_page(t, n);
       while (n > 0 && ::fread(t, 1, 1, file_) == 1)
       {
         int c = page_[static_cast<unsigned char>(*t)];
@@ -983,7 +1159,7 @@ size_t Input::file_get(char *s, size_t n)
           {
             std::memcpy(t, utf8_, n);
             uidx_ = static_cast<unsigned short>(n);
-            ulen_ = static_cast<unsigned short>(l);
+            ulen_ = static_cast<unsigned short>(l - n);
             t += n;
             n = 0;
           }
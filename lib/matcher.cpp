@@ -49,8 +49,11 @@ size_t Matcher::match(Method method)
   {
     // advance to find a possible match at or after cur in the buffer
     txt_ = buf_ + cur_;
-    if ((this->*adv_)(cur_))
+    if (advance(cur_))
     {
+#if defined(WITH_MATCHER_STATS)
+      ++ctr_.verified;
+#endif
       if (pat_->lbk_ > 0)
       {
         // go back over lookback chars (never includes \n) from cur-1 back to txt (at most)
@@ -78,6 +81,9 @@ size_t Matcher::match(Method method)
           txt_ = buf_ + cur_;
           len_ = pat_->len_;
           set_current(k);
+#if defined(WITH_MATCHER_STATS)
+          ++ctr_.matches;
+#endif
           return cap_ = 1;
         }
       }
@@ -634,8 +640,11 @@ redo:
         }
         if (cur_ < pos_) // if we didn't fail on META alone
         {
-          if ((this->*adv_)(cur_ + 1))
+          if (advance(cur_ + 1))
           {
+#if defined(WITH_MATCHER_STATS)
+            ++ctr_.verified;
+#endif
             if (pat_->lbk_ > 0)
             {
               // go back and retry matching over lookback chars (never includes \n) from cur-1 to txt+1 (at most)
@@ -666,6 +675,9 @@ redo:
             txt_ = buf_ + cur_;
             len_ = pat_->len_;
             set_current(k);
+#if defined(WITH_MATCHER_STATS)
+            ++ctr_.matches;
+#endif
             return cap_ = 1;
           }
         }
@@ -699,8 +711,13 @@ redo:
         if (cap_ != 0)
         {
           // note that lbk is zero (no lookback), because we can't make a DFA cut for empty-matching patterns
-          if ((this->*adv_)(cur_ + 1))
+          if (advance(cur_ + 1))
+          {
+#if defined(WITH_MATCHER_STATS)
+            ++ctr_.verified;
+#endif
             goto scan;
+          }
           set_current(++cur_);
           // at end of input, no matches remain
           cap_ = 0;
@@ -744,6 +761,10 @@ redo:
       cap_ = 0;
     }
   }
+#if defined(WITH_MATCHER_STATS)
+  if (method == Const::FIND && cap_ > 0)
+    ++ctr_.matches;
+#endif
   DBGLOG("Return: cap = %zu txt = '%s' len = %zu pos = %zu got = %d", cap_, std::string(txt_, len_).c_str(), len_, pos_, got_);
   DBGLOG("END match()");
   return cap_;
@@ -752,14 +773,14 @@ redo:
 // expand code for all pin minimal cases
 #define INIT_ADV_PAT_PIN_CASE(PIN) \
   if (pat_->min_ <= 1) \
-    adv_ = &Matcher::advance_pattern_pin##PIN##_one; \
+    REFLEX_INIT_ADVANCE(advance_pattern_pin##PIN##_one); \
   else \
-    adv_ = &Matcher::advance_pattern_pin##PIN##_pma;
+    REFLEX_INIT_ADVANCE(advance_pattern_pin##PIN##_pma);
 
 /// Initialize specialized pattern search methods to advance the engine to a possible match
 void Matcher::init_advance()
 {
-  adv_ = &Matcher::advance_none;
+  REFLEX_INIT_ADVANCE(advance_none);
   if (pat_ == NULL)
     return;
   if (pat_->len_ == 0)
@@ -770,9 +791,9 @@ void Matcher::init_advance()
     {
       case 1:
         if (pat_->min_ <= 1)
-          adv_ = &Matcher::advance_pattern_pin1_one;
+          REFLEX_INIT_ADVANCE(advance_pattern_pin1_one);
         else
-          adv_ = &Matcher::advance_pattern_pin1_pma;
+          REFLEX_INIT_ADVANCE(advance_pattern_pin1_pma);
         break;
 #if defined(HAVE_AVX512BW) || defined(HAVE_AVX2) || defined(HAVE_SSE2) || defined(HAVE_NEON)
       case 2:
@@ -802,55 +823,55 @@ void Matcher::init_advance()
         {
           case 0:
           case 1:
-            adv_ = &Matcher::advance_pattern_min1;
+            REFLEX_INIT_ADVANCE(advance_pattern_min1);
             break;
           case 2:
-            adv_ = &Matcher::advance_pattern_min2;
+            REFLEX_INIT_ADVANCE(advance_pattern_min2);
             break;
 #if !defined(WITH_PM3_PM5)
           case 3:
-            adv_ = &Matcher::advance_pattern_min3;
+            REFLEX_INIT_ADVANCE(advance_pattern_min3);
             break;
 #endif
           default:
-            adv_ = &Matcher::advance_pattern_mink;
+            REFLEX_INIT_ADVANCE(advance_pattern_mink);
         }
     }
   }
   else if (pat_->len_ == 1)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::advance_char;
+      REFLEX_INIT_ADVANCE(advance_char);
     else
-      adv_ = &Matcher::advance_char_pma;
+      REFLEX_INIT_ADVANCE(advance_char_pma);
   }
   else if (pat_->len_ == 2)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::advance_chars<2>;
+      REFLEX_INIT_ADVANCE(advance_chars<2>);
     else
-      adv_ = &Matcher::advance_chars_pma<2>;
+      REFLEX_INIT_ADVANCE(advance_chars_pma<2>);
   }
   else if (pat_->len_ == 3)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::advance_chars<3>;
+      REFLEX_INIT_ADVANCE(advance_chars<3>);
     else
-      adv_ = &Matcher::advance_chars_pma<3>;
+      REFLEX_INIT_ADVANCE(advance_chars_pma<3>);
   }
   else if (pat_->bmd_ == 0)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::advance_string;
+      REFLEX_INIT_ADVANCE(advance_string);
     else
-      adv_ = &Matcher::advance_string_pma;
+      REFLEX_INIT_ADVANCE(advance_string_pma);
   }
   else
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::advance_string_bm;
+      REFLEX_INIT_ADVANCE(advance_string_bm);
     else
-      adv_ = &Matcher::advance_string_bm_pma;
+      REFLEX_INIT_ADVANCE(advance_string_bm_pma);
   }
 #if defined(HAVE_AVX512BW) || defined(HAVE_AVX2)
   // AVX2 runtime optimized function callback overrides
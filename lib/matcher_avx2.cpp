@@ -48,9 +48,9 @@ namespace reflex {
 
 #define SIMD_INIT_ADV_PAT_PIN_CASE_AVX2(PIN) \
   if (pat_->min_ <= 0) \
-    adv_ = &Matcher::simd_advance_pattern_pin##PIN##_one_avx2; \
+    REFLEX_INIT_ADVANCE(simd_advance_pattern_pin##PIN##_one_avx2); \
   else \
-    adv_ = &Matcher::simd_advance_pattern_pin##PIN##_pma_avx2;
+    REFLEX_INIT_ADVANCE(simd_advance_pattern_pin##PIN##_pma_avx2);
 
 // AVX2 runtime optimized function callback overrides
 void Matcher::simd_init_advance_avx2()
@@ -61,7 +61,7 @@ void Matcher::simd_init_advance_avx2()
     {
       case 1:
         if (pat_->min_ >= 2)
-          adv_ = &Matcher::simd_advance_pattern_pin1_pma_avx2;
+          REFLEX_INIT_ADVANCE(simd_advance_pattern_pin1_pma_avx2);
         break;
       case 2:
         SIMD_INIT_ADV_PAT_PIN_CASE_AVX2(2);
@@ -92,19 +92,19 @@ void Matcher::simd_init_advance_avx2()
         switch (pat_->min_)
         {
           case 4:
-            adv_ = &Matcher::simd_advance_pattern_min4_avx2<4>;
+            REFLEX_INIT_ADVANCE(simd_advance_pattern_min4_avx2<4>);
             break;
           case 5:
-            adv_ = &Matcher::simd_advance_pattern_min4_avx2<5>;
+            REFLEX_INIT_ADVANCE(simd_advance_pattern_min4_avx2<5>);
             break;
           case 6:
-            adv_ = &Matcher::simd_advance_pattern_min4_avx2<6>;
+            REFLEX_INIT_ADVANCE(simd_advance_pattern_min4_avx2<6>);
             break;
           case 7:
-            adv_ = &Matcher::simd_advance_pattern_min4_avx2<7>;
+            REFLEX_INIT_ADVANCE(simd_advance_pattern_min4_avx2<7>);
             break;
           case 8:
-            adv_ = &Matcher::simd_advance_pattern_min4_avx2<8>;
+            REFLEX_INIT_ADVANCE(simd_advance_pattern_min4_avx2<8>);
             break;
         }
 #endif
@@ -117,23 +117,23 @@ void Matcher::simd_init_advance_avx2()
   else if (pat_->len_ == 2)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::simd_advance_chars_avx2<2>;
+      REFLEX_INIT_ADVANCE(simd_advance_chars_avx2<2>);
     else
-      adv_ = &Matcher::simd_advance_chars_pma_avx2<2>;
+      REFLEX_INIT_ADVANCE(simd_advance_chars_pma_avx2<2>);
   }
   else if (pat_->len_ == 3)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::simd_advance_chars_avx2<3>;
+      REFLEX_INIT_ADVANCE(simd_advance_chars_avx2<3>);
     else
-      adv_ = &Matcher::simd_advance_chars_pma_avx2<3>;
+      REFLEX_INIT_ADVANCE(simd_advance_chars_pma_avx2<3>);
   }
   else if (pat_->bmd_ == 0)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::simd_advance_string_avx2;
+      REFLEX_INIT_ADVANCE(simd_advance_string_avx2);
     else
-      adv_ = &Matcher::simd_advance_string_pma_avx2;
+      REFLEX_INIT_ADVANCE(simd_advance_string_pma_avx2);
   }
 }
 
@@ -60,23 +60,23 @@ void Matcher::simd_init_advance_avx512bw()
   else if (pat_->len_ == 2)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::simd_advance_chars_avx512bw<2>;
+      REFLEX_INIT_ADVANCE(simd_advance_chars_avx512bw<2>);
     else
-      adv_ = &Matcher::simd_advance_chars_pma_avx512bw<2>;
+      REFLEX_INIT_ADVANCE(simd_advance_chars_pma_avx512bw<2>);
   }
   else if (pat_->len_ == 3)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::simd_advance_chars_avx512bw<3>;
+      REFLEX_INIT_ADVANCE(simd_advance_chars_avx512bw<3>);
     else
-      adv_ = &Matcher::simd_advance_chars_pma_avx512bw<3>;
+      REFLEX_INIT_ADVANCE(simd_advance_chars_pma_avx512bw<3>);
   }
   else if (pat_->bmd_ == 0)
   {
     if (pat_->min_ == 0)
-      adv_ = &Matcher::simd_advance_string_avx512bw;
+      REFLEX_INIT_ADVANCE(simd_advance_string_avx512bw);
     else
-      adv_ = &Matcher::simd_advance_string_pma_avx512bw;
+      REFLEX_INIT_ADVANCE(simd_advance_string_pma_avx512bw);
   }
 }
 
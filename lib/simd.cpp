@@ -420,4 +420,242 @@ bool isutf8(const char *s, const char *e)
   return true;
 }
 
+// Find the first byte in string s up to e to escape, a control character below the given bound other than except or one of the five bytes in chars
+const char *find_escape(const char *s, const char *e, uint8_t below, uint8_t except, const char chars[5])
+{
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2) || defined(HAVE_SSE2)
+
+  if (s <= e - 16)
+  {
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2)
+    if (s <= e - 32 && have_HW_AVX2())
+      s = simd_find_escape_avx2(s, e, below, except, chars);
+#endif
+    // below > 0: bytes up to below - 1 are control characters to escape, otherwise none
+    const __m128i vbelow = _mm_set1_epi8(static_cast<char>(below - 1));
+    const __m128i vnone = _mm_set1_epi8(below > 0 ? 0 : -1);
+    const __m128i vexcept = _mm_set1_epi8(static_cast<char>(except));
+    const __m128i vc0 = _mm_set1_epi8(chars[0]);
+    const __m128i vc1 = _mm_set1_epi8(chars[1]);
+    const __m128i vc2 = _mm_set1_epi8(chars[2]);
+    const __m128i vc3 = _mm_set1_epi8(chars[3]);
+    const __m128i vc4 = _mm_set1_epi8(chars[4]);
+    while (s <= e - 16)
+    {
+      __m128i vs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+      __m128i vctrl = _mm_cmpeq_epi8(_mm_min_epu8(vs, vbelow), vs);
+      vctrl = _mm_andnot_si128(_mm_or_si128(vnone, _mm_cmpeq_epi8(vs, vexcept)), vctrl);
+      __m128i veq = _mm_or_si128(_mm_cmpeq_epi8(vs, vc0), _mm_cmpeq_epi8(vs, vc1));
+      veq = _mm_or_si128(veq, _mm_or_si128(_mm_cmpeq_epi8(vs, vc2), _mm_cmpeq_epi8(vs, vc3)));
+      veq = _mm_or_si128(veq, _mm_cmpeq_epi8(vs, vc4));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(vctrl, veq)));
+      if (mask != 0)
+        return s + ctz(mask);
+      s += 16;
+    }
+  }
+
+#elif defined(HAVE_NEON)
+
+  if (s <= e - 16)
+  {
+    const uint8x16_t vbelow = vdupq_n_u8(below);
+    const uint8x16_t vexcept = vdupq_n_u8(except);
+    const uint8x16_t vc0 = vdupq_n_u8(static_cast<uint8_t>(chars[0]));
+    const uint8x16_t vc1 = vdupq_n_u8(static_cast<uint8_t>(chars[1]));
+    const uint8x16_t vc2 = vdupq_n_u8(static_cast<uint8_t>(chars[2]));
+    const uint8x16_t vc3 = vdupq_n_u8(static_cast<uint8_t>(chars[3]));
+    const uint8x16_t vc4 = vdupq_n_u8(static_cast<uint8_t>(chars[4]));
+    while (s <= e - 16)
+    {
+      uint8x16_t vs = vld1q_u8(reinterpret_cast<const uint8_t*>(s));
+      uint8x16_t vctrl = vbicq_u8(vcltq_u8(vs, vbelow), vceqq_u8(vs, vexcept));
+      uint8x16_t veq = vorrq_u8(vceqq_u8(vs, vc0), vceqq_u8(vs, vc1));
+      veq = vorrq_u8(veq, vorrq_u8(vceqq_u8(vs, vc2), vceqq_u8(vs, vc3)));
+      veq = vorrq_u8(veq, vceqq_u8(vs, vc4));
+      uint64x2_t vm = vreinterpretq_u64_u8(vorrq_u8(vctrl, veq));
+      // locate the byte to escape in the 16 bytes with the scalar loop below
+      if ((vgetq_lane_u64(vm, 0) | vgetq_lane_u64(vm, 1)) != 0)
+        break;
+      s += 16;
+    }
+  }
+
+#endif
+
+  while (s < e)
+  {
+    uint8_t c = static_cast<uint8_t>(*s);
+    if ((c < below && c != except) || c == static_cast<uint8_t>(chars[0]) || c == static_cast<uint8_t>(chars[1]) || c == static_cast<uint8_t>(chars[2]) || c == static_cast<uint8_t>(chars[3]) || c == static_cast<uint8_t>(chars[4]))
+      return s;
+    ++s;
+  }
+  return e;
+}
+
+// Copy the leading ASCII bytes of string s of n bytes to t, returns the number of bytes copied
+size_t copy_ascii(const char *s, size_t n, char *t)
+{
+  size_t i = 0;
+
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2) || defined(HAVE_SSE2)
+
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2)
+  if (n >= 32 && have_HW_AVX2())
+    i = simd_copy_ascii_avx2(s, n, t);
+#endif
+  while (i + 16 <= n)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+    if (_mm_movemask_epi8(v) != 0)
+      break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(t + i), v);
+    i += 16;
+  }
+
+#elif defined(HAVE_NEON)
+
+  const uint8x16_t v80 = vdupq_n_u8(0x80);
+  while (i + 16 <= n)
+  {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(s + i));
+    uint64x2_t vm = vreinterpretq_u64_u8(vandq_u8(v, v80));
+    if ((vgetq_lane_u64(vm, 0) | vgetq_lane_u64(vm, 1)) != 0)
+      break;
+    vst1q_u8(reinterpret_cast<uint8_t*>(t + i), v);
+    i += 16;
+  }
+
+#endif
+
+  while (i < n && (s[i] & 0x80) == 0)
+  {
+    t[i] = s[i];
+    ++i;
+  }
+  return i;
+}
+
+// Narrow the leading ASCII UTF-16 code units of string s of n code units to bytes in t, big endian when be is true, returns the number of code units narrowed
+size_t narrow_utf16(const char *s, size_t n, char *t, bool be)
+{
+  size_t i = 0;
+
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2) || defined(HAVE_SSE2)
+
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2)
+  if (n >= 32 && have_HW_AVX2())
+    i = simd_narrow_utf16_avx2(s, n, t, be);
+#endif
+  // ASCII code units have zero bits in the mask, big endian code units are byte-swapped in the vector
+  const __m128i vmask = _mm_set1_epi16(static_cast<short>(be ? 0x80ff : 0xff80));
+  const __m128i v0 = _mm_setzero_si128();
+  while (i + 8 <= n)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 2 * i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, vmask), v0)) != 0xffff)
+      break;
+    if (be)
+      v = _mm_srli_epi16(v, 8);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(t + i), _mm_packus_epi16(v, v));
+    i += 8;
+  }
+
+#elif defined(HAVE_NEON)
+
+  const uint16x8_t v7f = vdupq_n_u16(0x7f);
+  while (i + 8 <= n)
+  {
+    uint8x16_t vb = vld1q_u8(reinterpret_cast<const uint8_t*>(s + 2 * i));
+    if (be)
+      vb = vrev16q_u8(vb);
+    uint16x8_t v = vreinterpretq_u16_u8(vb);
+    if (vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(vcgtq_u16(v, v7f))), 0) != 0)
+      break;
+    vst1_u8(reinterpret_cast<uint8_t*>(t + i), vmovn_u16(v));
+    i += 8;
+  }
+
+#endif
+
+  while (i < n)
+  {
+    const unsigned char *u = reinterpret_cast<const unsigned char*>(s + 2 * i);
+    int c = be ? u[0] << 8 | u[1] : u[0] | u[1] << 8;
+    if (c >= 0x80)
+      break;
+    t[i++] = static_cast<char>(c);
+  }
+  return i;
+}
+
+// Narrow the leading ASCII UTF-32 code units of string s of n code units to bytes in t, big endian when be is true, returns the number of code units narrowed
+size_t narrow_utf32(const char *s, size_t n, char *t, bool be)
+{
+  size_t i = 0;
+
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2) || defined(HAVE_SSE2)
+
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2)
+  if (n >= 32 && have_HW_AVX2())
+    i = simd_narrow_utf32_avx2(s, n, t, be);
+#endif
+  // ASCII code units have zero bits in the mask, big endian code units are byte-swapped in the vector
+  const __m128i vmask = _mm_set1_epi32(static_cast<int>(be ? 0x80ffffff : 0xffffff80));
+  const __m128i v0 = _mm_setzero_si128();
+  while (i + 16 <= n)
+  {
+    __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 4 * i));
+    __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 4 * i + 16));
+    __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 4 * i + 32));
+    __m128i v4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 4 * i + 48));
+    __m128i vm = _mm_and_si128(_mm_or_si128(_mm_or_si128(v1, v2), _mm_or_si128(v3, v4)), vmask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(vm, v0)) != 0xffff)
+      break;
+    if (be)
+    {
+      v1 = _mm_srli_epi32(v1, 24);
+      v2 = _mm_srli_epi32(v2, 24);
+      v3 = _mm_srli_epi32(v3, 24);
+      v4 = _mm_srli_epi32(v4, 24);
+    }
+    __m128i vt = _mm_packus_epi16(_mm_packs_epi32(v1, v2), _mm_packs_epi32(v3, v4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(t + i), vt);
+    i += 16;
+  }
+
+#elif defined(HAVE_NEON)
+
+  const uint32x4_t v7f = vdupq_n_u32(0x7f);
+  while (i + 8 <= n)
+  {
+    uint8x16_t vb1 = vld1q_u8(reinterpret_cast<const uint8_t*>(s + 4 * i));
+    uint8x16_t vb2 = vld1q_u8(reinterpret_cast<const uint8_t*>(s + 4 * i + 16));
+    if (be)
+    {
+      vb1 = vrev32q_u8(vb1);
+      vb2 = vrev32q_u8(vb2);
+    }
+    uint32x4_t v1 = vreinterpretq_u32_u8(vb1);
+    uint32x4_t v2 = vreinterpretq_u32_u8(vb2);
+    uint32x4_t vm = vorrq_u32(vcgtq_u32(v1, v7f), vcgtq_u32(v2, v7f));
+    if ((vgetq_lane_u32(vm, 0) | vgetq_lane_u32(vm, 1) | vgetq_lane_u32(vm, 2) | vgetq_lane_u32(vm, 3)) != 0)
+      break;
+    vst1_u8(reinterpret_cast<uint8_t*>(t + i), vmovn_u16(vcombine_u16(vmovn_u32(v1), vmovn_u32(v2))));
+    i += 8;
+  }
+
+#endif
+
+  while (i < n)
+  {
+    const unsigned char *u = reinterpret_cast<const unsigned char*>(s + 4 * i);
+    uint32_t c = be ? static_cast<uint32_t>(u[0]) << 24 | u[1] << 16 | u[2] << 8 | u[3] : static_cast<uint32_t>(u[3]) << 24 | u[2] << 16 | u[1] << 8 | u[0];
+    if (c >= 0x80)
+      break;
+    t[i++] = static_cast<char>(c);
+  }
+  return i;
+}
+
 } // namespace reflex
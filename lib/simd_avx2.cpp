@@ -148,4 +148,130 @@ bool simd_isutf8_avx2(const char *& b, const char *e)
   return true;
 }
 
+// Partially find the first byte to escape, a control character below the given bound other than except or one of five bytes
+const char *simd_find_escape_avx2(const char *s, const char *e, uint8_t below, uint8_t except, const char chars[5])
+{
+#if defined(HAVE_AVX2) || defined(HAVE_AVX512BW)
+  // below > 0: bytes up to below - 1 are control characters to escape, otherwise none
+  const __m256i vbelow = _mm256_set1_epi8(static_cast<char>(below - 1));
+  const __m256i vnone = _mm256_set1_epi8(below > 0 ? 0 : -1);
+  const __m256i vexcept = _mm256_set1_epi8(static_cast<char>(except));
+  const __m256i vc0 = _mm256_set1_epi8(chars[0]);
+  const __m256i vc1 = _mm256_set1_epi8(chars[1]);
+  const __m256i vc2 = _mm256_set1_epi8(chars[2]);
+  const __m256i vc3 = _mm256_set1_epi8(chars[3]);
+  const __m256i vc4 = _mm256_set1_epi8(chars[4]);
+  while (s <= e - 32)
+  {
+    __m256i vs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+    __m256i vctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(vs, vbelow), vs);
+    vctrl = _mm256_andnot_si256(_mm256_or_si256(vnone, _mm256_cmpeq_epi8(vs, vexcept)), vctrl);
+    __m256i veq = _mm256_or_si256(_mm256_cmpeq_epi8(vs, vc0), _mm256_cmpeq_epi8(vs, vc1));
+    veq = _mm256_or_si256(veq, _mm256_or_si256(_mm256_cmpeq_epi8(vs, vc2), _mm256_cmpeq_epi8(vs, vc3)));
+    veq = _mm256_or_si256(veq, _mm256_cmpeq_epi8(vs, vc4));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(vctrl, veq)));
+    if (mask != 0)
+      return s + ctz(mask);
+    s += 32;
+  }
+#else
+  (void)e;
+  (void)below;
+  (void)except;
+  (void)chars;
+#endif
+  return s;
+}
+
+// Partially copy the leading ASCII bytes of s to t, returns the number of bytes copied
+size_t simd_copy_ascii_avx2(const char *s, size_t n, char *t)
+{
+  size_t i = 0;
+#if defined(HAVE_AVX2) || defined(HAVE_AVX512BW)
+  while (i + 32 <= n)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+    if (_mm256_movemask_epi8(v) != 0)
+      break;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(t + i), v);
+    i += 32;
+  }
+#else
+  (void)s;
+  (void)n;
+  (void)t;
+#endif
+  return i;
+}
+
+// Partially narrow the leading ASCII UTF-16 code units of s to t, returns the number of code units narrowed
+size_t simd_narrow_utf16_avx2(const char *s, size_t n, char *t, bool be)
+{
+  size_t i = 0;
+#if defined(HAVE_AVX2) || defined(HAVE_AVX512BW)
+  // ASCII code units have zero bits in the mask, big endian code units are byte-swapped in the vector
+  const __m256i vmask = _mm256_set1_epi16(static_cast<short>(be ? 0x80ff : 0xff80));
+  while (i + 32 <= n)
+  {
+    __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 2 * i));
+    __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 2 * i + 32));
+    if (!_mm256_testz_si256(_mm256_or_si256(v0, v1), vmask))
+      break;
+    if (be)
+    {
+      v0 = _mm256_srli_epi16(v0, 8);
+      v1 = _mm256_srli_epi16(v1, 8);
+    }
+    // pack per 128 bit lane, then put the four 64 bit quarters in order
+    __m256i vt = _mm256_permute4x64_epi64(_mm256_packus_epi16(v0, v1), 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(t + i), vt);
+    i += 32;
+  }
+#else
+  (void)s;
+  (void)n;
+  (void)t;
+  (void)be;
+#endif
+  return i;
+}
+
+// Partially narrow the leading ASCII UTF-32 code units of s to t, returns the number of code units narrowed
+size_t simd_narrow_utf32_avx2(const char *s, size_t n, char *t, bool be)
+{
+  size_t i = 0;
+#if defined(HAVE_AVX2) || defined(HAVE_AVX512BW)
+  // ASCII code units have zero bits in the mask, big endian code units are byte-swapped in the vector
+  const __m256i vmask = _mm256_set1_epi32(static_cast<int>(be ? 0x80ffffff : 0xffffff80));
+  const __m256i vperm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  while (i + 32 <= n)
+  {
+    __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 4 * i));
+    __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 4 * i + 32));
+    __m256i v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 4 * i + 64));
+    __m256i v3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 4 * i + 96));
+    if (!_mm256_testz_si256(_mm256_or_si256(_mm256_or_si256(v0, v1), _mm256_or_si256(v2, v3)), vmask))
+      break;
+    if (be)
+    {
+      v0 = _mm256_srli_epi32(v0, 24);
+      v1 = _mm256_srli_epi32(v1, 24);
+      v2 = _mm256_srli_epi32(v2, 24);
+      v3 = _mm256_srli_epi32(v3, 24);
+    }
+    // pack per 128 bit lane, then put the eight 32 bit parts in order
+    __m256i vt = _mm256_packus_epi16(_mm256_packs_epi32(v0, v1), _mm256_packs_epi32(v2, v3));
+    vt = _mm256_permutevar8x32_epi32(vt, vperm);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(t + i), vt);
+    i += 32;
+  }
+#else
+  (void)s;
+  (void)n;
+  (void)t;
+  (void)be;
+#endif
+  return i;
+}
+
 } // namespace reflex
@@ -0,0 +1,299 @@
+/******************************************************************************\
+* Copyright (c) 2019, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      cache.cpp
+@brief     --cache=FILE to skip files that did not match the same search before
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2019-2025, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#include "cache.hpp"
+#include "stats.hpp"
+#include <ctime>
+
+// the cache file starts with a magic line, followed by keys each with the files that did not match, stored as 64-bit little-endian numbers
+static const char cache_magic[] = "ugrep cache 2\n";
+
+// the size of a file stored in the cache file: device, inode, size, mtime, ctime and age
+static const uint64_t entry_size = 6 * sizeof(uint64_t);
+
+// read a 64-bit little-endian number
+static bool read_number(FILE *file, uint64_t& number)
+{
+  unsigned char buf[8];
+  if (fread(buf, sizeof(buf), 1, file) != 1)
+    return false;
+  number = 0;
+  for (int i = 7; i >= 0; --i)
+    number = (number << 8) | buf[i];
+  return true;
+}
+
+// append a 64-bit little-endian number
+static void append_number(std::string& data, uint64_t number)
+{
+  for (int i = 0; i < 8; ++i)
+    data.push_back(static_cast<char>(number >> (8 * i)));
+}
+
+// open the cache file and load the files that did not match a search with the given key
+void Cache::open(const char *cache_filename, const std::string& cache_key)
+{
+  filename.assign(cache_filename);
+  key.assign(cache_key);
+  others.clear();
+  entries.clear();
+  records.clear();
+  racy = static_cast<uint64_t>(time(NULL) - CACHE_RACY_TIME) * 1000000;
+  changed = true;
+  enabled = true;
+
+  FILE *file = NULL;
+
+  if (fopenw_s(&file, cache_filename, "rb") != 0)
+    return;
+
+  struct stat buf;
+  char magic[sizeof(cache_magic) - 1];
+
+  if (fstat(fileno(file), &buf) == 0 &&
+      fread(magic, sizeof(magic), 1, file) == 1 &&
+      memcmp(magic, cache_magic, sizeof(magic)) == 0)
+  {
+    // the number of bytes left to read limits the sizes read
+    uint64_t left = static_cast<uint64_t>(buf.st_size) - sizeof(magic);
+    uint64_t size;
+    uint64_t count;
+    std::string other;
+
+    while (left >= 2 * sizeof(uint64_t) && read_number(file, size) && size <= left - 2 * sizeof(uint64_t))
+    {
+      other.resize(size);
+      if (size > 0 && fread(&other[0], size, 1, file) != 1)
+        break;
+
+      if (!read_number(file, count))
+        break;
+
+      left -= 2 * sizeof(uint64_t) + size;
+
+      if (count > left / entry_size)
+        break;
+
+      left -= count * entry_size;
+
+      if (other == key)
+      {
+        // the key is saved unchanged when it is the most recently used key
+        changed = !others.empty();
+
+        uint64_t dev;
+        uint64_t ino;
+        Entry entry;
+
+        // the files age by one search until visited again
+        while (count-- > 0 && read_number(file, dev) && read_number(file, ino) && read_number(file, entry.size) && read_number(file, entry.mtime) && read_number(file, entry.ctime) && read_number(file, entry.age))
+        {
+          ++entry.age;
+          entries.emplace(Id(dev, ino), entry);
+        }
+      }
+      else
+      {
+        // keep the other key and its files as stored, to save them again
+        std::string data;
+        append_number(data, size);
+        data.append(other);
+        append_number(data, count);
+
+        size_t offset = data.size();
+        data.resize(offset + count * entry_size);
+        if (count > 0 && fread(&data[offset], count * entry_size, 1, file) != 1)
+          break;
+
+        others.emplace_back(std::move(data));
+      }
+    }
+  }
+
+  fclose(file);
+}
+
+// save the files that did not match to the cache file and close the cache, the other threads must have stopped
+void Cache::close()
+{
+  if (!enabled)
+    return;
+
+  enabled = false;
+
+  // drop the files not visited by the last CACHE_MAX_AGE searches with this key, save the cache file when the age of a file changed
+  for (Entries::iterator entry = entries.begin(); entry != entries.end(); )
+  {
+    if (entry->second.age > 0)
+      changed = true;
+
+    if (entry->second.age >= CACHE_MAX_AGE)
+      entry = entries.erase(entry);
+    else
+      ++entry;
+  }
+
+  if (changed || !records.empty())
+  {
+    for (const auto& record : records)
+      entries[record.first] = record.second;
+
+    // write a temporary file first, then rename it to replace the cache file
+    std::string temp(filename);
+#ifndef OS_WIN_OR_MINGW
+    temp.append(".").append(std::to_string(getpid()));
+#else
+    temp.append(".tmp");
+#endif
+
+    FILE *file = NULL;
+
+    if (fopenw_s(&file, temp.c_str(), "wb") != 0)
+    {
+      warning("cannot save cache file", filename.c_str());
+    }
+    else
+    {
+      // the key of this search is saved first as the most recently used
+      std::string data(cache_magic, sizeof(cache_magic) - 1);
+      append_number(data, key.size());
+      data.append(key);
+      append_number(data, entries.size());
+
+      for (const auto& entry : entries)
+      {
+        append_number(data, entry.first.dev);
+        append_number(data, entry.first.ino);
+        append_number(data, entry.second.size);
+        append_number(data, entry.second.mtime);
+        append_number(data, entry.second.ctime);
+        append_number(data, entry.second.age);
+      }
+
+      bool ok = fwrite(data.data(), data.size(), 1, file) == 1;
+
+      for (size_t i = 0; ok && i < others.size() && i + 1 < CACHE_MAX_KEYS; ++i)
+        ok = fwrite(others[i].data(), others[i].size(), 1, file) == 1;
+
+      if (fclose(file) != 0)
+        ok = false;
+
+      if (!ok || std::rename(temp.c_str(), filename.c_str()) != 0)
+      {
+        warning("cannot save cache file", filename.c_str());
+        remove(temp.c_str());
+      }
+    }
+  }
+
+  others.clear();
+  entries.clear();
+  records.clear();
+}
+
+// return true if the file did not match the search before and is unchanged, called by the thread that selects files to search
+bool Cache::skip(const struct stat& buf)
+{
+  if (!S_ISREG(buf.st_mode))
+    return false;
+
+  Entries::iterator found = entries.find(Id(buf.st_dev, buf.st_ino));
+
+  if (found == entries.end())
+  {
+    Stats::score_miss();
+    return false;
+  }
+
+  Entry current = entry(buf);
+
+  if (found->second.size == current.size && found->second.mtime == current.mtime && found->second.ctime == current.ctime)
+  {
+    // the file was visited by this search
+    found->second.age = 0;
+    Stats::score_hit();
+    return true;
+  }
+
+  // the file changed, search it again
+  entries.erase(found);
+  changed = true;
+  Stats::score_invalidated();
+
+  return false;
+}
+
+// record a file that did not match the search, stat info obtained before the file was searched, thread-safe
+void Cache::record(const struct stat& buf)
+{
+  Entry current = entry(buf);
+
+  // the file may change again without changing its times when it was modified just before the search started
+  if (current.mtime >= racy || current.ctime >= racy)
+    return;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  records.emplace_back(Id(buf.st_dev, buf.st_ino), current);
+}
+
+// the entry of a file with its size and times
+Cache::Entry Cache::entry(const struct stat& buf)
+{
+  Entry entry;
+  entry.size = static_cast<uint64_t>(buf.st_size);
+  entry.age = 0;
+#if defined(HAVE_STAT_ST_ATIM) && defined(HAVE_STAT_ST_MTIM) && defined(HAVE_STAT_ST_CTIM)
+  entry.mtime = static_cast<uint64_t>(buf.st_mtim.tv_sec) * 1000000 + buf.st_mtim.tv_nsec / 1000;
+  entry.ctime = static_cast<uint64_t>(buf.st_ctim.tv_sec) * 1000000 + buf.st_ctim.tv_nsec / 1000;
+#elif defined(HAVE_STAT_ST_ATIMESPEC) && defined(HAVE_STAT_ST_MTIMESPEC) && defined(HAVE_STAT_ST_CTIMESPEC)
+  entry.mtime = static_cast<uint64_t>(buf.st_mtimespec.tv_sec) * 1000000 + buf.st_mtimespec.tv_nsec / 1000;
+  entry.ctime = static_cast<uint64_t>(buf.st_ctimespec.tv_sec) * 1000000 + buf.st_ctimespec.tv_nsec / 1000;
+#else
+  entry.mtime = static_cast<uint64_t>(buf.st_mtime) * 1000000;
+  entry.ctime = static_cast<uint64_t>(buf.st_ctime) * 1000000;
+#endif
+  return entry;
+}
+
+bool                     Cache::enabled = false;
+std::string              Cache::filename;
+std::string              Cache::key;
+std::vector<std::string> Cache::others;
+Cache::Entries           Cache::entries;
+Cache::Records           Cache::records;
+uint64_t                 Cache::racy = 0;
+bool                     Cache::changed = false;
+std::mutex               Cache::mutex;
@@ -0,0 +1,148 @@
+/******************************************************************************\
+* Copyright (c) 2019, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      cache.hpp
+@brief     --cache=FILE to skip files that did not match the same search before
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2019-2025, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+
+The cache file holds the files that did not match a search, per key of the
+patterns and the options that determine which files match.  A file is
+identified by its device and inode number and is skipped by a search with the
+same key when its size, modification time and status change time are unchanged.
+Files modified less than CACHE_RACY_TIME seconds before the search started are
+not recorded, because a change made within the timestamp granularity of the
+file system may not update these times.  Files that were not visited by the
+last CACHE_MAX_AGE searches with the same key are dropped from the cache file,
+such that files deleted, renamed or no longer searched do not accumulate.
+*/
+
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include "ugrep.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --cache=FILE: the maximum number of keys with the files that did not match kept in the cache file, the least recently used are dropped
+#ifndef CACHE_MAX_KEYS
+# define CACHE_MAX_KEYS 8
+#endif
+
+// --cache=FILE: files not visited by this number of searches with the same key are dropped
+#ifndef CACHE_MAX_AGE
+# define CACHE_MAX_AGE 4
+#endif
+
+// --cache=FILE: files modified less than this number of seconds before the search started are not recorded
+#ifndef CACHE_RACY_TIME
+# define CACHE_RACY_TIME 2
+#endif
+
+// static class to skip files that did not match a search with the same key before, loaded from and saved to the cache file
+class Cache {
+
+ public:
+
+  // open the cache file and load the files that did not match a search with the given key
+  static void open(const char *filename, const std::string& key);
+
+  // save the files that did not match to the cache file and close the cache, the other threads must have stopped
+  static void close();
+
+  // return true if the file did not match the search before and is unchanged, called by the thread that selects files to search
+  static bool skip(const struct stat& buf);
+
+  // record a file that did not match the search, stat info obtained before the file was searched, thread-safe
+  static void record(const struct stat& buf);
+
+  static bool enabled; // --cache=FILE: skip and record files that did not match
+
+ protected:
+
+  // the size and times in microseconds of a file that did not match and the number of searches since the file was visited
+  struct Entry {
+    uint64_t size;
+    uint64_t mtime;
+    uint64_t ctime;
+    uint64_t age;
+  };
+
+  // a file identified by its device and inode number
+  struct Id {
+
+    Id(uint64_t dev, uint64_t ino)
+      :
+        dev(dev),
+        ino(ino)
+    { }
+
+    bool operator==(const Id& id) const
+    {
+      return dev == id.dev && ino == id.ino;
+    }
+
+    uint64_t dev;
+    uint64_t ino;
+
+  };
+
+  // hash of a file Id
+  struct Hash {
+
+    size_t operator()(const Id& id) const
+    {
+      return static_cast<size_t>(id.ino ^ (id.dev * 0x9e3779b97f4a7c15ULL));
+    }
+
+  };
+
+  typedef std::unordered_map<Id,Entry,Hash> Entries;
+  typedef std::vector<std::pair<Id,Entry>>  Records;
+
+  // the entry of a file with its size and times
+  static Entry entry(const struct stat& buf);
+
+  static std::string              filename; // the cache file
+  static std::string              key;      // the key of the search
+  static std::vector<std::string> others;   // the other keys and their files as stored in the cache file, most recently used first
+  static Entries                  entries;  // the files that did not match the search before, only accessed by the thread that selects files
+  static Records                  records;  // the files recorded by the search that did not match
+  static uint64_t                 racy;     // files modified at or after this time in microseconds are not recorded
+  static bool                     changed;  // true if entries were removed and must be saved
+  static std::mutex               mutex;    // protects records when worker threads record files
+
+};
+
+#endif
@@ -780,3 +780,119 @@ std::string CNF::first() const
 
   return "";
 }
+
+// deep copy the terms of a CNF to this CNF
+void CNF::assign(const CNF& cnf)
+{
+  terms.clear();
+
+  for (const auto& i : cnf.terms)
+  {
+    terms.emplace_back();
+
+    auto& term = terms.back();
+
+    for (const auto& j : i)
+    {
+      if (j)
+        term.emplace_back(new std::string(*j));
+      else
+        term.emplace_back();
+    }
+  }
+}
+
+// return true if lines that match this CNF also match the given CNF, i.e. this CNF refines the given CNF
+bool CNF::implies(const CNF& cnf) const
+{
+  // each ALT-term of the given CNF must be implied by an ALT-term of this CNF
+  for (const auto& i : cnf.terms)
+  {
+    bool implied = false;
+
+    for (const auto& j : terms)
+    {
+      if (implies(j, i))
+      {
+        implied = true;
+        break;
+      }
+    }
+
+    if (!implied)
+      return false;
+  }
+
+  return true;
+}
+
+// return true if lines that match the ALT-term also match the other ALT-term
+bool CNF::implies(const Term& term, const Term& other)
+{
+  // an empty ALT-term matches anything
+  if (other.empty())
+    return true;
+
+  if (term.empty())
+    return false;
+
+  // the ALT pattern must imply the other ALT pattern
+  if (term.front() && !(other.front() && implies(*term.front(), *other.front())))
+    return false;
+
+  // each ALT-NOT pattern must also be an ALT-NOT pattern of the other ALT-term
+  for (auto i = ++term.begin(); i != term.end(); ++i)
+  {
+    bool found = false;
+
+    for (auto j = ++other.begin(); j != other.end(); ++j)
+    {
+      if (*i && *j && **i == **j)
+      {
+        found = true;
+        break;
+      }
+    }
+
+    if (!found)
+      return false;
+  }
+
+  return true;
+}
+
+// return true if lines that match the pattern also match the other pattern
+bool CNF::implies(const std::string& pattern, const std::string& other)
+{
+  if (pattern == other)
+    return true;
+
+  // -w and -x: a string that contains the other string does not imply that the other string matches as a word or as a line
+  if (flag_word_regexp || flag_line_regexp)
+    return false;
+
+  // a literal string implies the literal strings it contains
+  std::string string;
+  std::string substring;
+
+  return literal(pattern, string) && literal(other, substring) && string.find(substring) != std::string::npos;
+}
+
+// return true if the pattern is a literal string, possibly quoted with \Q and \E, and assign the unquoted string
+bool CNF::literal(const std::string& pattern, std::string& string)
+{
+  // -F: a pattern quoted with \Q and \E without \E in the string
+  if (pattern.size() >= 4 && pattern.compare(0, 2, "\\Q") == 0 && pattern.compare(pattern.size() - 2, 2, "\\E") == 0)
+  {
+    string.assign(pattern, 2, pattern.size() - 4);
+    return string.find("\\E") == std::string::npos;
+  }
+
+  // --free-space: spacing and comments are ignored
+  if (flag_free_space || pattern.find_first_of("\\^$.[]|()*+?{}") != std::string::npos)
+    return false;
+
+  string.assign(pattern);
+
+  return true;
+}
@@ -143,6 +143,12 @@ class CNF {
   // return the first ALT-terms of the CNF
   std::string first() const;
 
+  // deep copy the terms of a CNF to this CNF
+  void assign(const CNF& cnf);
+
+  // return true if lines that match this CNF also match the given CNF, i.e. this CNF refines the given CNF
+  bool implies(const CNF& cnf) const;
+
   // quote a pattern with \Q and \E
   static void quote(std::string& pattern)
   {
@@ -208,6 +214,15 @@ class CNF {
 
  protected:
 
+  // return true if lines that match the ALT-term also match the other ALT-term
+  static bool implies(const Term& term, const Term& other);
+
+  // return true if lines that match the pattern also match the other pattern
+  static bool implies(const std::string& pattern, const std::string& other);
+
+  // return true if the pattern is a literal string, possibly quoted with \Q and \E, and assign the unquoted string
+  static bool literal(const std::string& pattern, std::string& string);
+
   struct OpTree {
 
     // a node is either NONE (a leaf node with a regex pattern) or an AND, OR, NOT operation with a list of OpTree operands
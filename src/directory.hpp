@@ -0,0 +1,283 @@
+/******************************************************************************\
+* Copyright (c) 2019, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      directory.hpp
+@brief     class to read directories and to stat directory entries
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2019-2025, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#ifndef DIRECTORY_HPP
+#define DIRECTORY_HPP
+
+#include "ugrep.hpp"
+#include "stats.hpp"
+#include "cache.hpp"
+
+#ifndef OS_WIN_OR_MINGW
+
+#include <dirent.h>
+
+// Linux: read directories with getdents64() into a large buffer and stat entries with statx() relative to the directory
+#if defined(__linux__)
+# include <sys/syscall.h>
+# include <sys/sysmacros.h>
+# if defined(SYS_getdents64)
+#  define WITH_GETDENTS
+# endif
+# if defined(STATX_TYPE) && defined(STATX_INO) && defined(AT_STATX_SYNC_AS_STAT)
+#  define WITH_STATX
+# endif
+# include <sys/ioctl.h>
+# include <linux/fs.h>
+# include <linux/fiemap.h>
+# if defined(FS_IOC_FIEMAP)
+#  define WITH_FIEMAP
+# endif
+#endif
+
+// getdents64() buffer size, a large buffer reduces the number of round trips to read directories on network file systems
+#ifndef GETDENTS_BUFFER_SIZE
+# define GETDENTS_BUFFER_SIZE 65536
+#endif
+
+// read the entries of a directory, one directory at a time, and stat entries relative to the directory opened
+class Directory {
+
+ public:
+
+#ifdef WITH_GETDENTS
+  // the linux_dirent64 directory entry returned by getdents64() with d_ino, d_type and d_name compatible with struct dirent
+  struct Dirent {
+    uint64_t       d_ino;
+    int64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[1];
+  };
+#else
+  typedef struct dirent Dirent;
+#endif
+
+  Directory()
+    :
+      dir(NULL),
+      dir_fd(-1),
+      buf(NULL),
+      pos(0),
+      len(0)
+  { }
+
+  ~Directory()
+  {
+    close();
+#ifdef WITH_GETDENTS
+    delete[] buf;
+#endif
+  }
+
+  // open directory to read, return true if successful
+  bool open(const char *pathname)
+  {
+    close();
+
+#ifdef WITH_GETDENTS
+
+    dir_fd = ::open(pathname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0)
+      return false;
+
+    if (buf == NULL)
+      buf = new char[GETDENTS_BUFFER_SIZE];
+
+    pos = 0;
+    len = 0;
+
+    return true;
+
+#else
+
+    dir = opendir(pathname);
+    if (dir == NULL)
+      return false;
+
+    return true;
+
+#endif
+  }
+
+  // read the next directory entry or NULL when done
+  const Dirent *read()
+  {
+#ifdef WITH_GETDENTS
+
+    if (pos >= len)
+    {
+      if (dir_fd < 0)
+        return NULL;
+
+      long n = syscall(SYS_getdents64, dir_fd, buf, GETDENTS_BUFFER_SIZE);
+      if (n <= 0)
+        return NULL;
+
+      pos = 0;
+      len = static_cast<size_t>(n);
+    }
+
+    const Dirent *dirent = reinterpret_cast<const Dirent*>(buf + pos);
+    pos += dirent->d_reclen;
+
+    return dirent;
+
+#else
+
+    return dir != NULL ? readdir(dir) : NULL;
+
+#endif
+  }
+
+  // close the directory
+  void close()
+  {
+#ifdef WITH_GETDENTS
+    if (dir_fd >= 0)
+      ::close(dir_fd);
+#else
+    if (dir != NULL)
+      closedir(dir);
+#endif
+    dir = NULL;
+    dir_fd = -1;
+  }
+
+  // stat a directory entry with the given basename in the directory opened, otherwise pathname, like stat() when follow is true or lstat(), only the metadata requested by --sort, --read-order, --min-size, --max-size, --cache and mtime is guaranteed
+  int stat(const char *pathname, const char *basename, bool follow, struct stat& buf, bool mtime = false)
+  {
+    // --stats=phases: stat is part of the directory traversal
+    Stats::Timer timer(Stats::TRAVERSE);
+
+#ifdef WITH_STATX
+
+    // only fetch the type and inode unless more metadata is needed, this avoids attribute revalidation on network file systems
+    unsigned int mask = STATX_TYPE | STATX_INO;
+    if (flag_min_size > 0 || flag_max_size > 0 || flag_sort_key == Sort::SIZE || flag_read_order_key == Order::SIZE)
+      mask |= STATX_SIZE;
+    if (mtime || flag_sort_key == Sort::CHANGED)
+      mask |= STATX_MTIME;
+    if (flag_sort_key == Sort::USED)
+      mask |= STATX_ATIME;
+    if (flag_sort_key == Sort::CREATED)
+      mask |= STATX_CTIME;
+    if (Cache::enabled)
+      mask |= STATX_SIZE | STATX_MTIME | STATX_CTIME;
+
+    struct statx stx;
+    int flags = AT_STATX_SYNC_AS_STAT | AT_NO_AUTOMOUNT | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+
+    if (dir_fd >= 0 ? statx(dir_fd, basename, flags, mask, &stx) != 0 : statx(AT_FDCWD, pathname, flags, mask, &stx) != 0)
+      return -1;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.st_mode = stx.stx_mode;
+    buf.st_ino = static_cast<ino_t>(stx.stx_ino);
+    buf.st_dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    buf.st_nlink = stx.stx_nlink;
+    buf.st_size = static_cast<off_t>(stx.stx_size);
+    buf.st_atim.tv_sec = stx.stx_atime.tv_sec;
+    buf.st_atim.tv_nsec = stx.stx_atime.tv_nsec;
+    buf.st_mtim.tv_sec = stx.stx_mtime.tv_sec;
+    buf.st_mtim.tv_nsec = stx.stx_mtime.tv_nsec;
+    buf.st_ctim.tv_sec = stx.stx_ctime.tv_sec;
+    buf.st_ctim.tv_nsec = stx.stx_ctime.tv_nsec;
+
+    return 0;
+
+#else
+
+    (void)basename;
+    (void)mtime;
+
+    return follow ? ::stat(pathname, &buf) : ::lstat(pathname, &buf);
+
+#endif
+  }
+
+  // --read-order=extent: get the physical location of the first extent of a directory entry with FIEMAP, or its inode number when not available
+  uint64_t extent(const char *pathname, const char *basename, uint64_t inode)
+  {
+    // --stats=phases: FIEMAP is part of the directory traversal
+    Stats::Timer timer(Stats::TRAVERSE);
+
+#ifdef WITH_FIEMAP
+
+    int fd = dir_fd >= 0 ? openat(dir_fd, basename, O_RDONLY | O_NONBLOCK | O_CLOEXEC) : ::open(pathname, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+    if (fd >= 0)
+    {
+      // struct fiemap followed by one struct fiemap_extent, aligned
+      uint64_t map[(sizeof(struct fiemap) + sizeof(struct fiemap_extent) + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+      struct fiemap *fiemap = reinterpret_cast<struct fiemap*>(map);
+
+      memset(map, 0, sizeof(map));
+      fiemap->fm_start = 0;
+      fiemap->fm_length = FIEMAP_MAX_OFFSET;
+      fiemap->fm_extent_count = 1;
+
+      bool ok = ioctl(fd, FS_IOC_FIEMAP, fiemap) == 0 && fiemap->fm_mapped_extents > 0;
+
+      ::close(fd);
+
+      if (ok)
+        return fiemap->fm_extents[0].fe_physical;
+    }
+
+#else
+
+    (void)pathname;
+    (void)basename;
+
+#endif
+
+    return inode;
+  }
+
+ protected:
+
+  DIR   *dir;    // opendir() directory when not using getdents64()
+  int    dir_fd; // file descriptor of the directory opened or -1
+  char  *buf;    // getdents64() buffer
+  size_t pos;    // position of the next entry in the getdents64() buffer
+  size_t len;    // number of bytes in the getdents64() buffer
+
+};
+
+#endif
+
+#endif
@@ -65,6 +65,9 @@ class Flag {
 // --sort=KEY is n/a or by list, name, score, size, used time, changed time, created time
 enum class Sort { NA, NAME, BEST, SIZE, USED, CHANGED, CREATED, LIST };
 
+// --read-order=ORDER is n/a or by inode number, by first physical extent or largest file size first
+enum class Order { NA, INODE, EXTENT, SIZE };
+
 // -D, --devices and -d, --directories
 enum class Action { UNSP, SKIP, READ, RECURSE };
 
@@ -82,6 +85,7 @@ extern bool flag_csv;
 extern bool flag_decompress;
 extern bool flag_dereference;
 extern bool flag_dereference_files;
+extern bool flag_drop_cache;
 extern bool flag_files;
 extern bool flag_files_with_matches;
 extern bool flag_files_without_match;
@@ -113,6 +117,8 @@ extern bool flag_only_matching;
 extern bool flag_perl_regexp;
 extern bool flag_query;
 extern bool flag_quiet;
+extern bool flag_records;
+extern bool flag_records_spans;
 extern bool flag_sort_rev; // internal flag
 extern bool flag_split;
 extern bool flag_stdin; // internal flag
@@ -139,6 +145,7 @@ extern Flag flag_text;
 extern Flag flag_tree;
 extern Flag flag_ungroup;
 extern Sort flag_sort_key; // internal flag
+extern Order flag_read_order_key; // internal flag
 extern Action flag_devices_action; // internal flag
 extern Action flag_directories_action; // internal flag
 extern size_t flag_after_context;
@@ -171,6 +178,7 @@ extern size_t flag_tabs;
 extern size_t flag_width;
 extern size_t flag_zmax;
 extern const char *flag_binary_files;
+extern const char *flag_cache;
 extern const char *flag_color;
 extern const char *flag_color_query; // internal flag
 extern const char *flag_colors;
@@ -190,14 +198,17 @@ extern const char *flag_index;
 extern const char *flag_label;
 extern const char *flag_pager;
 extern const char *flag_pretty;
+extern const char *flag_read_order;
 extern const char *flag_replace;
 extern const char *flag_save_config;
 extern const char *flag_separator;
 extern const char *flag_separator_dash; // internal flag
 extern const char *flag_separator_bar; // internal flag
 extern const char *flag_sort;
+extern size_t flag_sort_buffer;
 extern const char *flag_stats;
 extern const char *flag_tag;
+extern const char *flag_trace;
 extern const char *flag_view;
 extern std::string              flag_filter;
 extern std::string              flag_hyperlink_prefix; // internal flag
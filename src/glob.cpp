@@ -88,6 +88,7 @@
 # define OS_WIN
 #endif
 
+#include "glob.hpp"
 #include <cstdio>
 #include <cstring>
 #include <cctype>
@@ -276,6 +277,174 @@ bool glob_match(const char *pathname, const char *basename, const char *glob, bo
   return path || match(basename, glob, icase, false, false);
 }
 
+// append a regex that matches the byte c, ignoring case of ASCII letters if icase is true
+static void regex_byte(std::string& regex, int c, bool icase)
+{
+  static const char xdigits[] = "0123456789abcdef";
+
+  if (icase && isalpha(c))
+  {
+    regex.push_back('[');
+    regex.push_back(static_cast<char>(tolower(c)));
+    regex.push_back(static_cast<char>(toupper(c)));
+    regex.push_back(']');
+  }
+  else if (isalnum(c))
+  {
+    regex.push_back(static_cast<char>(c));
+  }
+  else
+  {
+    regex.append("\\x");
+    regex.push_back(xdigits[(c >> 4) & 0xf]);
+    regex.push_back(xdigits[c & 0xf]);
+  }
+}
+
+#ifdef OS_WIN
+#define REGEX_PATHSEP   "\\x5c"
+#define REGEX_NOPATHSEP "[^\\x5c]"
+#else
+#define REGEX_PATHSEP   "/"
+#define REGEX_NOPATHSEP "[^/]"
+#endif
+
+// translate a glob to a regex that matches the basename, or the pathname without leading ./ and / when path is set, like glob_match() does for ASCII pathnames and when ascii is not set for all pathnames, returns false when the glob cannot be translated
+bool glob_regex(const char *glob, bool icase, std::string& regex, bool& path, bool& ascii)
+{
+  bool star = false;
+
+  regex.clear();
+  ascii = false;
+
+  // match pathname if glob contains a / or match the basename otherwise
+  path = strchr(glob, '/') != NULL;
+
+  // remove leading ./ or /
+  if (path)
+  {
+    if (glob[0] == '.' && glob[1] == '/')
+      glob += 2;
+    else if (glob[0] == '/')
+      ++glob;
+  }
+
+  if (*glob == '\0')
+    return false;
+
+  // a glob that starts with * or **/ and ends with * is costly to combine with other globs in a DFA
+  if (*glob == '*' && glob[strlen(glob) - 1] == '*')
+    return false;
+
+  while (*glob != '\0')
+  {
+    switch (*glob)
+    {
+      case '*':
+        if (*++glob == '*')
+        {
+          // trailing ** match everything after /
+          if (*++glob == '\0')
+          {
+            regex.append(path ? "[\\x00-\\xff]*" : REGEX_NOPATHSEP "*");
+            continue;
+          }
+
+          // ** followed by a / match zero or more directories, ** followed by anything else never matches
+          if (*glob != '/')
+            return false;
+
+          // glob_match() backtracks on the last ** only, not on a * before it, and does not match zero directories at the end of the pathname or at a / in the pathname
+          if (star || strstr(glob, "**") != NULL || strspn(glob, "*/") == strlen(glob) || glob[1] == '/' || (glob[1] == '*' && !regex.empty()))
+            return false;
+
+          regex.append("(?:[\\x00-\\xff]*" REGEX_PATHSEP ")?");
+          ++glob;
+          continue;
+        }
+
+        regex.append(REGEX_NOPATHSEP "*");
+        star = true;
+        continue;
+
+      case '?':
+        // match one ASCII character except /, UTF-8 multi-byte sequences are not translated
+        regex.append(REGEX_NOPATHSEP);
+        ascii = true;
+        ++glob;
+        continue;
+
+      case '[':
+      {
+        // translate an ASCII character class to the set of ASCII characters it matches
+        const char *end = glob + 1;
+        bool reverse = *end == '^' || *end == '!';
+
+        if (reverse)
+          ++end;
+
+        while (*end != '\0' && *end != ']')
+          if ((*end++ & 0x80) != 0)
+            return false;
+
+        if (*end == '\0')
+          return false;
+
+        std::string cls(glob, end - glob + 1);
+        std::string set;
+        char text[2] = { '\0', '\0' };
+
+        for (int c = 1; c < 0x80; ++c)
+        {
+          if (c == PATHSEP)
+            continue;
+
+          text[0] = static_cast<char>(c);
+
+          if (match(text, cls.c_str(), icase, false, false))
+            regex_byte(set, c, false);
+        }
+
+        if (set.empty())
+          return false;
+
+        regex.push_back('[');
+        regex.append(set);
+        regex.push_back(']');
+
+        // an inverted character class matches UTF-8 multi-byte sequences, which are not translated
+        if (reverse)
+          ascii = true;
+
+        glob = end + 1;
+        continue;
+      }
+
+      case '/':
+        regex.append(REGEX_PATHSEP);
+        ++glob;
+        continue;
+
+      case '\\':
+        // literal match \-escaped character
+        if (*++glob == '\0')
+          return false;
+        // FALLTHROUGH
+
+      default:
+        // tolower() and toupper() of non-ASCII depends on the locale
+        if (icase && (*glob & 0x80) != 0)
+          return false;
+
+        regex_byte(regex, static_cast<unsigned char>(*glob), icase);
+        ++glob;
+        continue;
+    }
+  }
+
+  return true;
+}
+
 // return wide character of UTF-8 multi-byte sequence, return ASCII lower case if icase is true
 static int utf8(const char **s, bool icase)
 {
@@ -34,5 +34,10 @@
 @copyright (c) BSD-3 License - see LICENSE.txt
 */
 
+#include <string>
+
 // pathname or basename glob matching, returns true or false, perform case-insensitive match if ic is true
 bool glob_match(const char *pathname, const char *basename, const char *glob, bool icase = false, bool lead = false, bool path = false);
+
+// translate a glob to a regex that matches the basename, or the pathname without leading ./ and / when path is set, like glob_match() does for ASCII pathnames and when ascii is not set for all pathnames, returns false when the glob cannot be translated
+bool glob_regex(const char *glob, bool icase, std::string& regex, bool& path, bool& ascii);
@@ -0,0 +1,292 @@
+/******************************************************************************\
+* Copyright (c) 2019, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      globs.hpp
+@brief     match pathnames against --include, --exclude and ignore file globs
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2019-2025, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+
+The globs of a vector are grouped in ranges, one range for the command-line
+globs and one for each ignore file imported during the directory traversal.
+The globs of a range that is matched many times are compiled into two DFAs,
+one for basename globs and one for pathname globs.  Each glob is a top-level
+alternative of a DFA in reverse order, such that the DFA accepts the last glob
+in the range that matches.  Globs that cannot be translated to a regex are
+matched with glob_match().  The DFAs of the globs imported from an ignore file
+are shared by the next searches while the ignore file is unchanged.
+*/
+
+#ifndef GLOBS_HPP
+#define GLOBS_HPP
+
+#include "ugrep.hpp"
+#include "glob.hpp"
+#include <reflex/matcher.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// the number of pathnames matched against a range of globs before the globs are compiled into DFAs
+#ifndef GLOBS_COMPILE_COUNT
+# define GLOBS_COMPILE_COUNT 4096
+#endif
+
+// the minimum number of globs in a range to compile into DFAs
+#ifndef GLOBS_COMPILE_MIN
+# define GLOBS_COMPILE_MIN 16
+#endif
+
+// match pathnames against a vector of globs that is extended and truncated at the back by the directory traversal
+class Globs {
+
+ public:
+
+  // the match count and DFAs of a range of globs, shared by the ranges of the same globs imported again from an unchanged ignore file
+  struct Set {
+
+    Set()
+      :
+        count(0),
+        compiled(false),
+        ascii(false)
+    { }
+
+    size_t              count;        // number of pathnames matched
+    bool                compiled;     // true if the DFAs are compiled
+    bool                ascii;        // true if the DFAs match ASCII pathnames only
+    reflex::Pattern     base_pattern; // DFA of the basename globs
+    reflex::Pattern     path_pattern; // DFA of the pathname globs
+    reflex::Matcher     base_matcher; // matcher of the basename DFA
+    reflex::Matcher     path_matcher; // matcher of the pathname DFA
+    std::vector<size_t> base_index;   // glob offset + 1 in the range of each basename DFA accept
+    std::vector<size_t> path_index;   // glob offset + 1 in the range of each pathname DFA accept
+    std::vector<size_t> other;        // glob offset + 1 in the range of the globs not translated, in reverse order
+
+  };
+
+  // the globs, where the first icase_size globs ignore case
+  Globs(const std::vector<std::string>& globs, const size_t& icase_size)
+    :
+      globs_(globs),
+      icase_size_(icase_size)
+  { }
+
+  // forget all ranges of globs when the vector of globs is rebuilt
+  void clear()
+  {
+    ranges_.clear();
+  }
+
+  // the globs pushed to the back of the vector of globs from index from form a new range with the given set, a new set is assigned if set is NULL
+  void extend(size_t from, std::shared_ptr<Set>& set)
+  {
+    extend(from);
+
+    if (globs_.size() > from)
+    {
+      if (!set)
+        set = std::make_shared<Set>();
+
+      ranges_.emplace_back(from, globs_.size(), set);
+    }
+  }
+
+  // forget the ranges of globs that were popped off the back of the vector of globs
+  void truncate()
+  {
+    while (!ranges_.empty() && ranges_.back().to > globs_.size())
+      ranges_.pop_back();
+  }
+
+  // return the index + 1 of the last glob that matches the pathname or basename, where a glob that starts with a ! is matched without the !, or return 0 if no glob matches
+  size_t last(const char *pathname, const char *basename)
+  {
+    extend(globs_.size());
+
+    // the newest range has the last globs
+    for (auto range = ranges_.rbegin(); range != ranges_.rend(); ++range)
+    {
+      size_t index = match(*range, pathname, basename);
+      if (index > 0)
+        return index;
+    }
+
+    return 0;
+  }
+
+ protected:
+
+  // a range of globs [from,to) and its set
+  struct Range {
+
+    Range(size_t from, size_t to, const std::shared_ptr<Set>& set)
+      :
+        from(from),
+        to(to),
+        set(set)
+    { }
+
+    size_t               from; // index of the first glob
+    size_t               to;   // index of the last glob + 1
+    std::shared_ptr<Set> set;  // match count and DFAs
+
+  };
+
+  // the globs pushed to the back of the vector of globs up to index to form a new range with a new set
+  void extend(size_t to)
+  {
+    size_t from = ranges_.empty() ? 0 : ranges_.back().to;
+
+    if (to > from)
+      ranges_.emplace_back(from, to, std::make_shared<Set>());
+  }
+
+  // return the index + 1 of the last glob in the range that matches the pathname or basename, or return 0 if no glob matches
+  size_t match(const Range& range, const char *pathname, const char *basename)
+  {
+    Set& set = *range.set;
+
+    // compile the DFAs when the range is matched many times, when compiling costs less than matching each glob
+    if (++set.count == GLOBS_COMPILE_COUNT && range.to - range.from >= GLOBS_COMPILE_MIN)
+      compile(range);
+
+    if (set.compiled && (!set.ascii || ascii(pathname)))
+    {
+      size_t offset = 0;
+
+      if (!set.base_index.empty())
+      {
+        set.base_matcher.input(reflex::Input(basename));
+        if (set.base_matcher.matches())
+          offset = set.base_index[set.base_matcher.accept() - 1];
+      }
+
+      if (!set.path_index.empty())
+      {
+        // skip leading ./ and / like glob_match()
+        while (pathname[0] == '.' && pathname[1] == PATHSEPCHR)
+          pathname += 2;
+        while (pathname[0] == PATHSEPCHR)
+          ++pathname;
+
+        set.path_matcher.input(reflex::Input(pathname));
+        if (set.path_matcher.matches())
+          offset = std::max(offset, set.path_index[set.path_matcher.accept() - 1]);
+      }
+
+      for (auto i : set.other)
+      {
+        if (i <= offset)
+          break;
+
+        if (match(range.from + i, pathname, basename))
+          return range.from + i;
+      }
+
+      return offset > 0 ? range.from + offset : 0;
+    }
+
+    for (size_t i = range.to; i > range.from; --i)
+      if (match(i, pathname, basename))
+        return i;
+
+    return 0;
+  }
+
+  // return true if the glob with index + 1 matches the pathname or basename
+  bool match(size_t i, const char *pathname, const char *basename) const
+  {
+    const std::string& glob = globs_[i - 1];
+    return glob_match(pathname, basename, glob.c_str() + (glob.front() == '!'), i <= icase_size_);
+  }
+
+  // compile the DFAs of the range of globs, the globs are matched with glob_match() when the DFAs cannot be compiled
+  void compile(const Range& range)
+  {
+    Set& set = *range.set;
+    std::string base_regex;
+    std::string path_regex;
+    std::string regex;
+
+    for (size_t i = range.to; i > range.from; --i)
+    {
+      const std::string& glob = globs_[i - 1];
+      bool path = false;
+      bool ascii = false;
+
+      if (glob_regex(glob.c_str() + (glob.front() == '!'), i <= icase_size_, regex, path, ascii))
+      {
+        std::string& alternatives = path ? path_regex : base_regex;
+        if (!alternatives.empty())
+          alternatives.push_back('|');
+        alternatives.append(regex);
+        (path ? set.path_index : set.base_index).push_back(i - range.from);
+        set.ascii |= ascii;
+      }
+      else
+      {
+        set.other.push_back(i - range.from);
+      }
+    }
+
+    try
+    {
+      if (!base_regex.empty())
+        set.base_matcher.pattern(set.base_pattern.assign(base_regex, "r"));
+      if (!path_regex.empty())
+        set.path_matcher.pattern(set.path_pattern.assign(path_regex, "r"));
+      set.compiled = true;
+    }
+
+    catch (reflex::regex_error&)
+    {
+      // the DFAs are too large or complex, keep matching the globs with glob_match()
+      set.base_index.clear();
+      set.path_index.clear();
+      set.other.clear();
+    }
+  }
+
+  // return true if the pathname is ASCII
+  static bool ascii(const char *pathname)
+  {
+    while (*pathname != '\0')
+      if ((*pathname++ & 0x80) != 0)
+        return false;
+    return true;
+  }
+
+  const std::vector<std::string>& globs_;      // the vector of globs
+  const size_t&                   icase_size_; // the first icase_size_ globs ignore case
+  std::vector<Range>              ranges_;     // ranges of globs, the last range has the last globs
+
+};
+
+#endif
@@ -38,6 +38,8 @@
 #define MMAP_HPP
 
 #include "ugrep.hpp"
+#include "stats.hpp"
+#include <vector>
 
 // --min-mmap and --max-mmap file size to allocate with mmap(), not greater than 4294967295LL, 0 disables mmap()
 #ifndef MIN_MMAP_SIZE
@@ -57,15 +59,229 @@
 # endif
 #endif
 
-// manage mmap state
-class MMap {
+// --drop-cache, --stats=phases and --stats=json page cache tracking require mincore() and posix_fadvise()
+#if defined(HAVE_MMAP) && MAX_MMAP_SIZE > 0 && defined(POSIX_FADV_DONTNEED)
+# define WITH_PAGE_CACHE
+#endif
+
+// --drop-cache: drop pages behind the read position every 1MB read
+#ifndef PAGE_CACHE_DROP_SIZE
+# define PAGE_CACHE_DROP_SIZE 1048576
+#endif
+
+// track the pages of a regular file searched that are resident in the page cache, to drop pages that were not cached before with --drop-cache
+class PageCache {
+
+ public:
+
+  PageCache()
+    :
+      fd(-1),
+      size(0),
+      page(0),
+      done(0),
+      run(0),
+      high(0),
+      pending(0)
+  { }
+
+  // start reading a file, record its pages resident in the page cache when the file is regular, only with --drop-cache, --stats=phases and --stats=json to avoid the cost per file
+  void open(int file_fd)
+  {
+    fd = -1;
+
+#ifdef WITH_PAGE_CACHE
+
+    if (!flag_drop_cache && (flag_stats == NULL || !Stats::timing))
+      return;
+
+    struct stat buf;
+    if (fstat(file_fd, &buf) != 0 || !S_ISREG(buf.st_mode) || buf.st_size <= 0 || static_cast<uint64_t>(buf.st_size) > static_cast<uint64_t>(std::numeric_limits<size_t>::max()))
+      return;
+
+    if (page == 0)
+      page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    size = static_cast<size_t>(buf.st_size);
+
+    if (!resident(file_fd, before))
+      return;
+
+    fd = file_fd;
+    done = 0;
+    run = 0;
+    high = 0;
+    pending = 0;
+
+#ifdef POSIX_FADV_NOREUSE
+    if (flag_drop_cache)
+      posix_fadvise(fd, 0, 0, POSIX_FADV_NOREUSE);
+#endif
+
+#else
+
+    (void)file_fd;
+
+#endif
+  }
+
+  // true if the current file is tracked
+  bool active() const
+  {
+    return fd >= 0;
+  }
+
+  // len bytes were read from the file, drop the pages behind the file position every PAGE_CACHE_DROP_SIZE bytes read
+  void read(size_t len)
+  {
+#ifdef WITH_PAGE_CACHE
+    pending += len;
+    if (fd >= 0 && pending >= PAGE_CACHE_DROP_SIZE)
+    {
+      pending = 0;
+      off_t pos = lseek(fd, 0, SEEK_CUR);
+      if (pos > 0)
+        drop(static_cast<size_t>(pos));
+    }
+#else
+    (void)len;
+#endif
+  }
+
+  // the file was consumed up to the given offset, drop the pages behind it that were not resident before
+  void drop(size_t offset)
+  {
+#ifdef WITH_PAGE_CACHE
+
+    if (fd < 0)
+      return;
+
+    if (offset > high)
+      high = std::min(offset, size);
+
+    if (!flag_drop_cache)
+      return;
+
+    // drop whole pages only, the last page of the file when at the end
+    size_t end = offset >= size ? before.size() : offset / page;
+
+    // extend the range back to the start of the run of pages that were not resident, because the kernel drops large folios only when covered as a whole
+    size_t i = done;
+    if (i > 0 && !(before[i - 1] & 1))
+      i = run;
+
+    while (i < end)
+    {
+      while (i < end && (before[i] & 1))
+        ++i;
+      size_t j = i;
+      while (j < end && !(before[j] & 1))
+        ++j;
+      if (j > i)
+      {
+        posix_fadvise(fd, static_cast<off_t>(i * page), static_cast<off_t>((j - i) * page), POSIX_FADV_DONTNEED);
+        run = i;
+      }
+      i = j;
+    }
+
+    if (end > done)
+      done = end;
+
+#else
+
+    (void)offset;
+
+#endif
+  }
+
+  // done reading the file, drop the pages that were not resident before, then score bytes read and pages left resident with --stats
+  void close()
+  {
+#ifdef WITH_PAGE_CACHE
+
+    if (fd < 0)
+      return;
+
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos > 0 && static_cast<size_t>(pos) > high)
+      high = std::min(static_cast<size_t>(pos), size);
+
+    if (flag_drop_cache)
+      drop(size);
+
+    if (flag_stats != NULL)
+    {
+      size_t pages = 0;
+      if (resident(fd, after))
+        for (size_t i = 0; i < after.size() && i < before.size(); ++i)
+          pages += (after[i] & 1) && !(before[i] & 1);
+      Stats::score_read(high, pages * page);
+    }
+
+    fd = -1;
+
+#endif
+  }
+
+  // the whole file or a window of it up to offset was memory mapped and read
+  void mapped(size_t offset)
+  {
+    if (fd >= 0 && offset > high)
+      high = std::min(offset, size);
+  }
+
+ protected:
+
+#ifdef WITH_PAGE_CACHE
+
+  // get the pages of the file that are resident in the page cache, mmap() and mincore() do not read or cache the pages
+  bool resident(int file_fd, std::vector<char>& vec)
+  {
+    size_t pages = (size + page - 1) / page;
+    void *addr = mmap(NULL, size, PROT_READ, MAP_SHARED, file_fd, 0);
+    if (addr == MAP_FAILED)
+      return false;
+    vec.resize(pages);
+#if defined(__linux__)
+    bool ok = mincore(addr, size, reinterpret_cast<unsigned char*>(vec.data())) == 0;
+#else
+    bool ok = mincore(reinterpret_cast<caddr_t>(addr), size, vec.data()) == 0;
+#endif
+    munmap(addr, size);
+    return ok;
+  }
+
+#endif
+
+  int               fd;      // the file descriptor of the file tracked or -1
+  size_t            size;    // the file size
+  size_t            page;    // the page size
+  size_t            done;    // the number of pages considered to drop so far
+  size_t            run;     // the start of the last run of pages dropped
+  size_t            high;    // the number of bytes read, the high water mark
+  size_t            pending; // the number of bytes read since the last drop()
+  std::vector<char> before;  // the pages resident before reading the file
+  std::vector<char> after;   // the pages resident after reading the file
+
+};
+
+// manage mmap state, also a window functor to slide a mmap window over files larger than --max-mmap
+class MMap : public reflex::AbstractMatcher::Window {
 
  public:
 
-  MMap()
+  MMap(PageCache& cache)
     :
+      cache(cache),
       mmap_base(NULL),
-      mmap_size(0)
+      mmap_size(0),
+      mmap_used(0),
+      page_size(0),
+      window_fd(-1),
+      window_file(0),
+      window_off(0),
+      window_len(0)
   { }
 
   ~MMap()
@@ -84,49 +300,43 @@ class MMap {
 
 #if defined(HAVE_MMAP) && MAX_MMAP_SIZE > 0
 
-    // get current input file and check if its encoding is plain
-    FILE *file = input.file();
-    if (file == NULL || input.file_encoding() != reflex::Input::file_encoding::plain)
-      return false;
-
-    // is this a regular file that is not too large (for size_t)?
-    int fd = fileno(file);
-    struct stat buf;
-    if (fstat(fd, &buf) != 0 || !S_ISREG(buf.st_mode) || static_cast<uint64_t>(buf.st_size) < MIN_MMAP_SIZE || static_cast<uint64_t>(buf.st_size) > static_cast<uint64_t>(std::numeric_limits<size_t>::max()))
+    // get regular file and its size
+    int fd;
+    if (!regular(input, fd, size))
       return false;
 
     // is this file not larger than --max-mmap?
-    size = static_cast<size_t>(buf.st_size);
     if (size > flag_max_mmap)
+    {
+      size = 0;
       return false;
+    }
 
     // mmap the file and round requested size up to 4K (typical page size)
     if (mmap_base == NULL)
     {
       // allocate fixed mmap region to reuse
-      mmap_size = (flag_max_mmap + 0xfff) & ~0xfffUL;
-      mmap_base = mmap(NULL, mmap_size, PROT_READ, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
-
-      // files are sequentially read
-      if (mmap_base == MAP_FAILED)
-        mmap_base = NULL;
-      else
-        madvise(reinterpret_cast<caddr_t>(mmap_base), mmap_size, MADV_SEQUENTIAL); // caddr_t is a pointer type cast from void*
+      if (!reserve((flag_max_mmap + 0xfff) & ~0xfffUL))
+      {
+        size = 0;
+        return false;
+      }
     }
 
-    if (mmap_base != NULL)
-    {
-      // mmap the (next) file to the fixed mmap region
-      base = static_cast<const char*>(mmap_base = mmap(mmap_base, mmap_size, PROT_READ, MAP_FIXED | MAP_PRIVATE, fd, 0));
+    // mmap the (next) file to the fixed mmap region
+    base = static_cast<const char*>(mmap_base = mmap(mmap_base, mmap_size, PROT_READ, MAP_FIXED | MAP_PRIVATE, fd, 0));
 
-      // mmap OK?
-      if (mmap_base != MAP_FAILED)
-        return true;
+    // mmap OK?
+    if (mmap_base != MAP_FAILED)
+    {
+      mmap_used = mmap_size;
+      return true;
     }
 
     // not OK
     mmap_base = NULL;
     mmap_size = 0;
+    mmap_used = 0;
     base = NULL;
     size = 0;
 
@@ -139,10 +349,203 @@ class MMap {
     return false;
   }
 
+  // release the pages of the mmap region mapped to the file, so the page cache can drop them
+  void release()
+  {
+#if defined(HAVE_MMAP) && MAX_MMAP_SIZE > 0
+    if (mmap_base != NULL && mmap_used > 0)
+      madvise(reinterpret_cast<caddr_t>(mmap_base), mmap_used, MADV_DONTNEED);
+#endif
+  }
+
+  // attempt to mmap a window of the given file-based input larger than --max-mmap, return true if successful with base and size of the initial window
+  bool window(reflex::Input& input, const char *& base, size_t& size)
+  {
+    base = NULL;
+    size = 0;
+
+#if defined(HAVE_MMAP) && MAX_MMAP_SIZE > 0
+
+    // mmap is disabled?
+    if (flag_max_mmap == 0)
+      return false;
+
+    // get regular file and its size, which should be larger than --max-mmap
+    int fd;
+    size_t file_size;
+    if (!regular(input, fd, file_size) || file_size <= flag_max_mmap)
+      return false;
+
+    if (page_size == 0)
+      page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    window_fd = fd;
+    window_file = file_size;
+    window_off = 0;
+    window_len = 0;
+
+    // map the initial window at the start of the file
+    base = (*this)(0, 0, size);
+
+    if (base != NULL && size > 0)
+      return true;
+
+    window_fd = -1;
+    size = 0;
+
+#else
+
+    (void)input;
+
+#endif
+
+    return false;
+  }
+
+  // slide the window to map at least len bytes at file offset off, return pointer to the data at offset off and set size to the number of bytes available, windows span --max-mmap bytes at least
+  char *operator()(size_t off, size_t len, size_t& size) override
+  {
+    size = 0;
+
+#if defined(HAVE_MMAP) && MAX_MMAP_SIZE > 0
+
+    if (window_fd < 0 || off > window_file)
+      return NULL;
+
+    // map pages from the page-aligned offset up to the end of the window, limited to the end of the file
+    size_t page_off = off & ~(page_size - 1);
+    size_t skip = off - page_off;
+    size_t want = std::min(std::max(len, static_cast<size_t>(flag_max_mmap)) + skip, window_file - page_off);
+    size_t map_len = (want + page_size - 1) & ~(page_size - 1);
+
+    // the mmap region must have an extra page to read past the end of the window
+    if (map_len + page_size > mmap_size)
+    {
+      if (mmap_base != NULL)
+        munmap(mmap_base, mmap_size);
+
+      mmap_base = NULL;
+      mmap_size = 0;
+      mmap_used = 0;
+      window_len = 0;
+
+      if (!reserve(map_len + page_size))
+        return NULL;
+    }
+    else if (window_len > 0 && page_off > window_off)
+    {
+      // --drop-cache: drop the pages behind the new window position from the page cache, the MAP_FIXED mmap below releases their mapping
+      cache.drop(page_off);
+    }
+
+    if (map_len > 0 && mmap(mmap_base, map_len, PROT_READ, MAP_FIXED | MAP_PRIVATE, window_fd, static_cast<off_t>(page_off)) == MAP_FAILED)
+    {
+      munmap(mmap_base, mmap_size);
+      mmap_base = NULL;
+      mmap_size = 0;
+      mmap_used = 0;
+      window_len = 0;
+      return NULL;
+    }
+
+    // replace stale file pages after the window with zero pages, so the window can be read past its end
+    if (mmap_used > map_len)
+    {
+      if (mmap(static_cast<char*>(mmap_base) + map_len, mmap_used - map_len, PROT_READ, MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE, -1, 0) == MAP_FAILED)
+      {
+        munmap(mmap_base, mmap_size);
+        mmap_base = NULL;
+        mmap_size = 0;
+        mmap_used = 0;
+        window_len = 0;
+        return NULL;
+      }
+    }
+
+    mmap_used = map_len;
+
+    if (map_len > 0)
+    {
+      // the window is sequentially read, prefetch the pages ahead of the previous window
+      size_t ahead = window_off + window_len > page_off ? std::min(window_off + window_len - page_off, map_len) : 0;
+      madvise(reinterpret_cast<caddr_t>(mmap_base), map_len, MADV_SEQUENTIAL);
+      if (ahead < map_len)
+        madvise(reinterpret_cast<caddr_t>(mmap_base) + ahead, map_len - ahead, MADV_WILLNEED);
+    }
+
+    window_off = page_off;
+    window_len = map_len;
+
+    cache.mapped(page_off + map_len);
+
+    size = std::min(window_file - off, map_len - skip);
+
+    return static_cast<char*>(mmap_base) + skip;
+
+#else
+
+    (void)off;
+    (void)len;
+
+    return NULL;
+
+#endif
+  }
+
  protected:
 
-  void  *mmap_base; // mmap() base address
-  size_t mmap_size; // mmap() allocated size
+#if defined(HAVE_MMAP) && MAX_MMAP_SIZE > 0
+
+  // get the file descriptor and size of a plain regular input file that is not too small and not too large (for size_t)
+  static bool regular(reflex::Input& input, int& fd, size_t& size)
+  {
+    // get current input file and check if its encoding is plain
+    FILE *file = input.file();
+    if (file == NULL || input.file_encoding() != reflex::Input::file_encoding::plain)
+      return false;
+
+    // is this a regular file that is not too large (for size_t)?
+    fd = fileno(file);
+    struct stat buf;
+    if (fstat(fd, &buf) != 0 || !S_ISREG(buf.st_mode) || static_cast<uint64_t>(buf.st_size) < MIN_MMAP_SIZE || static_cast<uint64_t>(buf.st_size) > static_cast<uint64_t>(std::numeric_limits<size_t>::max()))
+      return false;
+
+    size = static_cast<size_t>(buf.st_size);
+
+    return true;
+  }
+
+  // allocate fixed mmap region of the given size to reuse
+  bool reserve(size_t size)
+  {
+    mmap_size = size;
+    mmap_used = 0;
+    mmap_base = mmap(NULL, mmap_size, PROT_READ, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+
+    // files are sequentially read
+    if (mmap_base == MAP_FAILED)
+    {
+      mmap_base = NULL;
+      mmap_size = 0;
+      return false;
+    }
+
+    madvise(reinterpret_cast<caddr_t>(mmap_base), mmap_size, MADV_SEQUENTIAL); // caddr_t is a pointer type cast from void*
+
+    return true;
+  }
+
+#endif
+
+  PageCache& cache;       // page cache tracking of the file mapped
+  void      *mmap_base;   // mmap() base address
+  size_t     mmap_size;   // mmap() allocated size
+  size_t     mmap_used;   // mmap() size of the region mapped to a file
+  size_t     page_size;   // page size to align window offsets
+  int        window_fd;   // file descriptor of the file mapped with a sliding window
+  size_t     window_file; // size of the file mapped with a sliding window
+  size_t     window_off;  // file offset of the current window, page aligned
+  size_t     window_len;  // length of the current window, page aligned
 
 };
 
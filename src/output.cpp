@@ -35,6 +35,17 @@
 */
 
 #include "output.hpp"
+#include "records.hpp"
+#include <reflex/simd.h>
+
+#if defined(OS_WIN)
+# define fseeko _fseeki64
+#endif
+
+#ifdef WITH_WRITEV
+# include <sys/uio.h>
+# include <poll.h>
+#endif
 
 // dump matching data in hex
 void Output::Dump::hex(short mode, size_t byte_offset, const char *data, size_t size)
@@ -615,42 +626,130 @@ std::pair<const char*,size_t> Output::capture(reflex::AbstractMatcher *matcher,
   return std::pair<const char*,size_t>(NULL, 0);
 }
 
-// output format with option --format-begin and --format-end
-void Output::format(const char *format, size_t matches)
+// FORMAT strings compiled before searching
+std::vector<std::pair<const char*,Output::Format::Fields>> Output::Format::formats;
+
+// --records: distinct empty FORMAT strings that select binary records
+const char Output::RECORDS_BEGIN[] = "";
+const char Output::RECORDS_OPEN[] = "";
+const char Output::RECORDS_MATCH[] = "";
+const char Output::RECORDS_END[] = "";
+
+// compile a FORMAT string into fields, returns false when the FORMAT string has an unterminated %[ARG]
+bool Output::Format::compile(const char *format, Fields& fields)
 {
-  const char *sep = NULL;
-  size_t len = 0;
+  bool valid = true;
   const char *s = format;
+
+  fields.clear();
+
   while (*s != '\0')
   {
-    int width = 0;
-    const char *arg = NULL;
-    const char *t = s;
+    Field field;
+
+    field.text = s;
+    field.arg = NULL;
+    field.len = 0;
+    field.width = 0;
+    field.plus = false;
+    field.c = '\0';
 
     while (*s != '\0' && *s != '%')
       ++s;
-    str(t, s - t);
+    field.size = s - field.text;
     if (*s == '\0' || *(s + 1) == '\0')
+    {
+      fields.push_back(field);
       break;
+    }
     ++s;
     if (*s == '{')
     {
       char *r = NULL;
-      width = strtol(s + 1, &r, 10);
+      field.plus = (s[1] == '+');
+      field.width = strtol(s + 1, &r, 10);
       if (r != NULL && *r == '}')
         s = r + 1;
     }
     if (*s == '[')
     {
-      arg = ++s;
+      field.arg = ++s;
       while (*s != '\0' && *s != ']')
         ++s;
+      if (*s == '\0')
+        valid = false;
       if (*s == '\0' || *(s + 1) == '\0')
+      {
+        field.arg = NULL;
+        fields.push_back(field);
         break;
+      }
       ++s;
+      field.len = s - field.arg - 1;
     }
 
-    int c = *s;
+    field.c = *s;
+    fields.push_back(field);
+    ++s;
+  }
+
+  return valid;
+}
+
+// compile a FORMAT string once before searching, returns false when the FORMAT string is invalid
+bool Output::Format::add(const char *format)
+{
+  if (format == NULL)
+    return true;
+
+  for (const auto& compiled : formats)
+    if (compiled.first == format)
+      return true;
+
+  formats.emplace_back(format, Fields());
+
+  return compile(format, formats.back().second);
+}
+
+// get the compiled fields of a FORMAT string added before searching, otherwise compile the FORMAT string
+const Output::Format::Fields& Output::Format::fields(const char *format)
+{
+  for (const auto& compiled : formats)
+    if (compiled.first == format)
+      return compiled.second;
+
+  static thread_local Fields fields;
+
+  compile(format, fields);
+
+  return fields;
+}
+
+// output format with option --format-begin and --format-end
+void Output::format(const char *format, size_t matches)
+{
+  // --records: output the header record or the end record with the number of files
+  if (format == RECORDS_BEGIN || format == RECORDS_END)
+  {
+    record(format == RECORDS_BEGIN ? RecordReader::HEADER : RecordReader::END, 8);
+    u64(format == RECORDS_BEGIN ? RecordReader::FORMAT_VERSION : matches);
+    return;
+  }
+
+  const char *sep = NULL;
+  size_t len = 0;
+  for (const Format::Field& field : Format::fields(format))
+  {
+    // output the literal text preceding the field
+    if (field.size > 0)
+      str(field.text, field.size);
+
+    if (field.c == '\0')
+      break;
+
+    int width = field.width;
+    const char *arg = field.arg;
+    int c = field.c;
 
     switch (c)
     {
@@ -658,7 +757,7 @@ void Output::format(const char *format, size_t matches)
         if (flag_initial_tab)
         {
           if (arg)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           chr('\t');
         }
         break;
@@ -667,7 +766,7 @@ void Output::format(const char *format, size_t matches)
         if (matches > 1)
         {
           if (arg)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           if (sep != NULL)
             str(sep, len);
           else
@@ -678,7 +777,7 @@ void Output::format(const char *format, size_t matches)
       case '$':
         sep = arg;
         if (arg != NULL)
-          len = s - arg - 1;
+          len = field.len;
         break;
 
       case 't':
@@ -719,12 +818,12 @@ void Output::format(const char *format, size_t matches)
 
       case '<':
         if (matches <= 1 && arg != NULL)
-          str(arg, s - arg - 1);
+          str(arg, field.len);
         break;
 
       case '>':
         if (matches > 1 && arg != NULL)
-          str(arg, s - arg - 1);
+          str(arg, field.len);
         break;
 
       case ',':
@@ -738,7 +837,6 @@ void Output::format(const char *format, size_t matches)
       default:
         chr(c);
     }
-    ++s;
   }
 }
 
@@ -753,42 +851,43 @@ bool Output::format(const char *format, const char *pathname, const std::string&
   if (matching != NULL)
     ++*matching;
 
+  // --records: output a file record that assigns the file id to the pathname and partname
+  if (format == RECORDS_OPEN)
+  {
+    size_t pathsize = strlen(pathname);
+    id_ = matches;
+    record(RecordReader::PATHNAME, 24 + pathsize + partname.size());
+    u64(id_);
+    u64(pathsize);
+    u64(partname.size());
+    str(pathname, pathsize);
+    str(partname);
+    return true;
+  }
+
+  // --records: output a match record or a count record
+  if (format == RECORDS_MATCH)
+  {
+    record_match(matches, matcher);
+    return true;
+  }
+
   size_t len = 0;
   const char *sep = NULL;
-  const char *s = format;
 
-  while (*s != '\0')
+  for (const Format::Field& field : Format::fields(format))
   {
-    bool plus = false;
-    int width = 0;
-    const char *arg = NULL;
-    const char *t = s;
+    // output the literal text preceding the field
+    if (field.size > 0)
+      str(field.text, field.size);
 
-    while (*s != '\0' && *s != '%')
-      ++s;
-    str(t, s - t);
-    if (*s == '\0' || *(s + 1) == '\0')
+    if (field.c == '\0')
       break;
-    ++s;
-    if (*s == '{')
-    {
-      char *r = NULL;
-      plus = (s[1] == '+');
-      width = strtol(s + 1, &r, 10);
-      if (r != NULL && *r == '}')
-        s = r + 1;
-    }
-    if (*s == '[')
-    {
-      arg = ++s;
-      while (*s != '\0' && *s != ']')
-        ++s;
-      if (*s == '\0' || *(s + 1) == '\0')
-        break;
-      ++s;
-    }
 
-    int c = *s;
+    bool plus = field.plus;
+    int width = field.width;
+    const char *arg = field.arg;
+    int c = field.c;
 
     switch (c)
     {
@@ -800,7 +899,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
             if (heading)
             {
               if (arg != NULL)
-                str(arg, s - arg - 1);
+                str(arg, field.len);
               str(pathname);
               if (flag_null)
                 chr('\0');
@@ -819,7 +918,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
         if (flag_with_filename && (heading || !partname.empty()))
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           if (heading)
             str(pathname);
           if (!partname.empty())
@@ -873,7 +972,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
         if (flag_with_filename && (heading || !partname.empty()))
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           if (!partname.empty())
           {
             std::string name;
@@ -914,7 +1013,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
         if (flag_with_filename && (heading || !partname.empty()))
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           if (!partname.empty())
           {
             std::string name;
@@ -955,7 +1054,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
         if (flag_line_number)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           num(matcher->lineno(), (arg == NULL && flag_initial_tab ? 6 : width));
           if (sep != NULL)
             str(sep, len);
@@ -980,7 +1079,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
         if (flag_column_number)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           num(matcher->columno() + 1, (arg == NULL && flag_initial_tab ? 3 : width));
           if (sep != NULL)
             str(sep, len);
@@ -1003,7 +1102,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
         if (flag_byte_offset)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           num(matcher->first(), width);
           if (sep != NULL)
             str(sep, len);
@@ -1029,7 +1128,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
         if (flag_initial_tab)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           chr('\t');
         }
         break;
@@ -1042,7 +1141,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
         if (next)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           if (sep != NULL)
             str(sep, len);
           else
@@ -1455,7 +1554,7 @@ bool Output::format(const char *format, const char *pathname, const std::string&
       case '$':
         sep = arg;
         if (arg != NULL)
-          len = s - arg - 1;
+          len = field.len;
         break;
 
       case 'R':
@@ -1481,12 +1580,12 @@ bool Output::format(const char *format, const char *pathname, const std::string&
 
       case '<':
         if (!next && arg != NULL)
-          str(arg, s - arg - 1);
+          str(arg, field.len);
         break;
 
       case '>':
         if (next && arg != NULL)
-          str(arg, s - arg - 1);
+          str(arg, field.len);
         break;
 
       case ',':
@@ -1515,49 +1614,81 @@ bool Output::format(const char *format, const char *pathname, const std::string&
         str(capture.first, capture.second);
         break;
     }
-    ++s;
   }
 
   return true;
 }
 
+// output --records binary match record or count record
+void Output::record_match(size_t matches, reflex::AbstractMatcher *matcher)
+{
+  if (flag_files_with_matches)
+    return;
+
+  if (flag_count)
+  {
+    record(RecordReader::COUNT, 16);
+    u64(id_);
+    u64(matches);
+    return;
+  }
+
+  // the text of the matching line(s) or the match with -o
+  const char *b = matcher->begin();
+  const char *e = b + matcher->size();
+  if (!flag_only_matching)
+  {
+    e = matcher->eol(); // warning: must call eol() before bol()
+    b = matcher->bol();
+  }
+
+  size_t text = flag_records_spans ? 0 : e - b;
+  record(RecordReader::MATCH, 48 + text);
+  u64(id_);
+  u64(matcher->lineno());
+  u64(matcher->columno() + 1);
+  u64(matcher->first());
+  u64(matcher->size());
+  u64(matcher->first() - (matcher->begin() - b));
+  str(b, text);
+
+  if (!flag_ungroup)
+    lineno_ = matcher->lineno();
+}
+
 // output formatted match with options -v --format
 void Output::format_invert(const char *format, const char *pathname, const std::string& partname, size_t matches, size_t lineno, size_t offset, const char *ptr, size_t size, bool& heading, bool next)
 {
+  // --records: output a line record of a non-matching line
+  if (format == RECORDS_MATCH)
+  {
+    size_t text = flag_records_spans ? 0 : size;
+    record(RecordReader::LINE, 48 + text);
+    u64(id_);
+    u64(lineno);
+    u64(1);
+    u64(offset);
+    u64(size);
+    u64(offset);
+    str(ptr, text);
+    return;
+  }
+
   size_t len = 0;
   const char *sep = NULL;
-  const char *s = format;
 
-  while (*s != '\0')
+  for (const Format::Field& field : Format::fields(format))
   {
-    int width = 0;
-    const char *arg = NULL;
-    const char *t = s;
+    // output the literal text preceding the field
+    if (field.size > 0)
+      str(field.text, field.size);
 
-    while (*s != '\0' && *s != '%')
-      ++s;
-    str(t, s - t);
-    if (*s == '\0' || *(s + 1) == '\0')
+    if (field.c == '\0')
       break;
-    ++s;
-    if (*s == '{')
-    {
-      char *r = NULL;
-      width = strtol(s + 1, &r, 10);
-      if (r != NULL && *r == '}')
-        s = r + 1;
-    }
-    if (*s == '[')
-    {
-      arg = ++s;
-      while (*s != '\0' && *s != ']')
-        ++s;
-      if (*s == '\0' || *(s + 1) == '\0')
-        break;
-      ++s;
-    }
 
-    int c = *s;
+    int width = field.width;
+    const char *arg = field.arg;
+    int c = field.c;
 
     switch (c)
     {
@@ -1569,7 +1700,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
             if (heading)
             {
               if (arg != NULL)
-                str(arg, s - arg - 1);
+                str(arg, field.len);
               str(pathname);
               if (flag_null)
                 chr('\0');
@@ -1588,7 +1719,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
         if (flag_with_filename && (heading || !partname.empty()))
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           if (heading)
             str(pathname);
           if (!partname.empty())
@@ -1642,7 +1773,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
         if (flag_with_filename && (heading || !partname.empty()))
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           if (!partname.empty())
           {
             std::string name;
@@ -1683,7 +1814,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
         if (flag_with_filename && (heading || !partname.empty()))
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           if (!partname.empty())
           {
             std::string name;
@@ -1724,7 +1855,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
         if (flag_line_number)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           num(lineno, (arg == NULL && flag_initial_tab ? 6 : width));
           if (sep != NULL)
             str(sep, len);
@@ -1741,7 +1872,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
         if (flag_column_number)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           chr('1');
           if (sep != NULL)
             str(sep, len);
@@ -1764,7 +1895,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
         if (flag_byte_offset)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           num(offset, width);
           if (sep != NULL)
             str(sep, len);
@@ -1781,7 +1912,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
         if (flag_initial_tab)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           chr('\t');
         }
         break;
@@ -1794,7 +1925,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
         if (next)
         {
           if (arg != NULL)
-            str(arg, s - arg - 1);
+            str(arg, field.len);
           if (sep != NULL)
             str(sep, len);
           else
@@ -1903,7 +2034,7 @@ void Output::format_invert(const char *format, const char *pathname, const std::
       case '$':
         sep = arg;
         if (arg != NULL)
-          len = s - arg - 1;
+          len = field.len;
         break;
 
       case 'R':
@@ -1929,12 +2060,12 @@ void Output::format_invert(const char *format, const char *pathname, const std::
 
       case '<':
         if (!next && arg != NULL)
-          str(arg, s - arg - 1);
+          str(arg, field.len);
         break;
 
       case '>':
         if (next && arg != NULL)
-          str(arg, s - arg - 1);
+          str(arg, field.len);
         break;
 
       case ',':
@@ -1962,10 +2093,13 @@ void Output::format_invert(const char *format, const char *pathname, const std::
         chr(c);
         break;
     }
-    ++s;
   }
 }
 
+// the bytes to escape by quote(), cpp(), csv() and json() in addition to control characters, and by xml()
+static const char quote_chars[5] = { '"', '\\', '"', '"', '"' };
+static const char xml_chars[5] = { '&', '<', '>', '"', 0x7f };
+
 // output a quoted string with escapes for \ and "
 void Output::quote(const char *data, size_t size)
 {
@@ -1977,6 +2111,11 @@ void Output::quote(const char *data, size_t size)
 
   while (s < e)
   {
+    // skip over the bytes that need no escaping
+    s = reflex::find_escape(s, e, 0, '\0', quote_chars);
+    if (s >= e)
+      break;
+
     if (*s == '\\' || *s == '"')
     {
       str(t, s - t);
@@ -2001,6 +2140,11 @@ void Output::cpp(const char *data, size_t size)
 
   while (s < e)
   {
+    // skip over the bytes that need no escaping
+    s = reflex::find_escape(s, e, 0x20, ' ', quote_chars);
+    if (s >= e)
+      break;
+
     int c = *s;
 
     if ((c & 0x80) == 0)
@@ -2059,6 +2203,11 @@ void Output::csv(const char *data, size_t size)
 
   while (s < e)
   {
+    // skip over the bytes that need no escaping
+    s = reflex::find_escape(s, e, 0x20, '\t', quote_chars);
+    if (s >= e)
+      break;
+
     int c = *s;
 
     if ((c & 0x80) == 0)
@@ -2144,6 +2293,11 @@ void Output::json(const char *data, size_t size)
 
   while (s < e)
   {
+    // skip over the bytes that need no escaping
+    s = reflex::find_escape(s, e, 0x20, ' ', quote_chars);
+    if (s >= e)
+      break;
+
     int c = *s;
 
     if ((c & 0x80) == 0)
@@ -2204,6 +2358,11 @@ void Output::xml(const char *data, size_t size)
 
   while (s < e)
   {
+    // skip over the bytes that need no escaping
+    s = reflex::find_escape(s, e, 0x20, ' ', xml_chars);
+    if (s >= e)
+      break;
+
     int c = *s;
 
     if ((c & 0x80) == 0)
@@ -2256,6 +2415,487 @@ void Output::xml(const char *data, size_t size)
   str(t, s - t);
 }
 
+// --sort: hand the buffers over to the writer thread to output in slot order
+void Output::hand_over()
+{
+  sync->writer->submit(slot_, buffers_, buf_, cur_ - buf_->data);
+
+  if (buffers_.empty())
+    grow();
+
+  buf_ = buffers_.begin();
+  cur_ = buf_->data;
+}
+
+#ifdef WITH_WRITEV
+
+// write the buffers from i up to buf and num bytes in buf to the file with writev(), returns false on error
+bool Output::gather(FILE *file, Buffers::iterator i, Buffers::iterator buf, size_t num)
+{
+  // output written to the FILE buffer goes first
+  if (fflush(file) != 0)
+    return false;
+
+  int fd = fileno(file);
+
+  if (fd < 0)
+  {
+    for (; i != buf; ++i)
+      if (fwrite(i->data, 1, SIZE, file) < SIZE)
+        return false;
+
+    return fwrite(buf->data, 1, num, file) == num && fflush(file) == 0;
+  }
+
+  struct iovec iovec[MAX_IOVEC];
+  bool done = false;
+
+  while (!done)
+  {
+    int n = 0;
+
+    // gather up to MAX_IOVEC buffers
+    while (n < MAX_IOVEC && !done)
+    {
+      if (i == buf)
+      {
+        iovec[n].iov_base = buf->data;
+        iovec[n].iov_len = num;
+        done = true;
+      }
+      else
+      {
+        iovec[n].iov_base = i->data;
+        iovec[n].iov_len = SIZE;
+        ++i;
+      }
+
+      ++n;
+    }
+
+    struct iovec *iov = iovec;
+
+    while (n > 0)
+    {
+      ssize_t nwritten = writev(fd, iov, n);
+
+      if (nwritten < 0)
+      {
+        if (errno == EINTR)
+          continue;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+          // non-blocking output file descriptor: wait until writable
+          struct pollfd pollfd;
+          pollfd.fd = fd;
+          pollfd.events = POLLOUT;
+          pollfd.revents = 0;
+          if (poll(&pollfd, 1, -1) >= 0 || errno == EINTR)
+            continue;
+        }
+
+        return false;
+      }
+
+      // skip the buffers written and advance in the buffer partially written
+      size_t k = static_cast<size_t>(nwritten);
+
+      Stats::score_phase(Stats::OUTPUT, k);
+
+      while (n > 0 && k >= iov->iov_len)
+      {
+        k -= iov->iov_len;
+        ++iov;
+        --n;
+      }
+
+      if (n > 0)
+      {
+        iov->iov_base = static_cast<char*>(iov->iov_base) + k;
+        iov->iov_len -= k;
+      }
+    }
+  }
+
+  return true;
+}
+
+#endif
+
+// swap NUL with LF in the output buffers for --null-data
+void Output::swap_null_data()
+{
+  for (Buffers::iterator i = buffers_.begin(); i != buf_; ++i)
+  {
+    char *data = i->data;
+
+    for (size_t k = 0; k < SIZE; ++k)
+    {
+      if (data[k] == '\0')
+        data[k] = '\n';
+      else if (data[k] == '\n')
+        data[k] = '\0';
+    }
+  }
+
+  size_t num = cur_ - buf_->data;
+
+  if (num > 0)
+  {
+    char *data = buf_->data;
+
+    for (size_t k = 0; k < num; ++k)
+    {
+      if (data[k] == '\0')
+        data[k] = '\n';
+      else if (data[k] == '\n')
+        data[k] = '\0';
+    }
+  }
+}
+
+// --sort: start the writer thread
+Output::Writer::Writer(FILE *file, Sync& sync)
+  :
+    out(new Output(file)),
+    sync(sync),
+    queue(NULL),
+    waiting(false),
+    mutex(),
+    work(),
+    pending(),
+    held(0),
+    spill_file(NULL),
+    spill_size(0),
+    thread(&Output::Writer::run, this)
+{ }
+
+// --sort: join the writer thread if not already joined and release the chunks held
+Output::Writer::~Writer()
+{
+  if (thread.joinable())
+    join();
+
+  for (auto& slot : pending)
+    for (auto chunk : slot.second)
+      delete chunk;
+
+  if (spill_file != NULL)
+    fclose(spill_file);
+
+  delete out;
+}
+
+// hand over the buffers up to and including buf with size bytes in buf, never waits for the slot's turn
+void Output::Writer::submit(size_t slot, Buffers& buffers, Buffers::iterator buf, size_t size)
+{
+  Chunk *chunk = new Chunk();
+
+  chunk->slot = slot;
+  chunk->buffers.splice(chunk->buffers.end(), buffers, buffers.begin(), ++buf);
+  chunk->size = size;
+  chunk->offset = -1;
+
+  push(chunk);
+}
+
+// mark the slot completed
+void Output::Writer::done(size_t slot)
+{
+  Chunk *chunk = new Chunk();
+
+  chunk->slot = slot;
+  chunk->offset = -1;
+  chunk->done = true;
+
+  push(chunk);
+}
+
+// output the remaining slots and wait for the writer thread to terminate
+void Output::Writer::join()
+{
+  Chunk *chunk = new Chunk();
+
+  chunk->offset = -1;
+  chunk->stop = true;
+
+  push(chunk);
+
+  thread.join();
+}
+
+// push a chunk on the lock-free completion queue, wake up the writer thread when it waits
+void Output::Writer::push(Chunk *chunk)
+{
+  chunk->next = queue.load(std::memory_order_relaxed);
+  while (!queue.compare_exchange_weak(chunk->next, chunk))
+    continue;
+
+  // the writer thread sets waiting before checking the queue again under the mutex, so we cannot miss it
+  if (waiting.load())
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    work.notify_one();
+  }
+}
+
+// pop all chunks from the completion queue in FIFO order, wait when the queue is empty
+Output::Writer::Chunk *Output::Writer::pop()
+{
+  Chunk *chunk = queue.exchange(NULL);
+
+  if (chunk == NULL)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    waiting.store(true);
+
+    while ((chunk = queue.exchange(NULL)) == NULL)
+      work.wait(lock);
+
+    waiting.store(false);
+  }
+
+  // reverse the LIFO list of chunks popped
+  Chunk *fifo = NULL;
+
+  while (chunk != NULL)
+  {
+    Chunk *next = chunk->next;
+    chunk->next = fifo;
+    fifo = chunk;
+    chunk = next;
+  }
+
+  return fifo;
+}
+
+// the writer thread
+void Output::Writer::run()
+{
+  // --trace=FILE: name this thread in the timeline
+  Trace::thread_name("writer");
+
+  bool stop = false;
+
+  while (!stop)
+  {
+    Chunk *chunk = pop();
+
+    while (chunk != NULL)
+    {
+      Chunk *next = chunk->next;
+
+      if (chunk->stop)
+      {
+        stop = true;
+        delete chunk;
+      }
+      else
+      {
+        write(chunk);
+      }
+
+      chunk = next;
+    }
+
+    if (held > flag_sort_buffer)
+      spill();
+
+    if (!out->eof && fflush(out->file) != 0)
+      cancel();
+  }
+}
+
+// output a chunk or hold it until its slot's turn, then advance to the next slot when the slot is completed
+void Output::Writer::write(Chunk *chunk)
+{
+  // --stats=phases: time writing output
+  Stats::Timer timer(Stats::OUTPUT);
+
+  if (out->eof || sync.cancelled())
+  {
+    delete chunk;
+    return;
+  }
+
+  if (chunk->slot != sync.last)
+  {
+    if (!chunk->buffers.empty())
+      held += (chunk->buffers.size() - 1) * SIZE + chunk->size;
+
+    pending[chunk->slot].push_back(chunk);
+    return;
+  }
+
+  output(chunk);
+
+  bool done = chunk->done;
+
+  delete chunk;
+
+  if (!done)
+    return;
+
+  // advance to the next slots and output their chunks held, unless cancelled
+  size_t slot = sync.last;
+
+  while (done && sync.last.compare_exchange_strong(slot, slot + 1))
+  {
+    ++slot;
+    done = false;
+
+    Pending::iterator i = pending.find(slot);
+
+    if (i != pending.end())
+    {
+      for (auto held_chunk : i->second)
+      {
+        if (held_chunk->offset < 0 && !held_chunk->buffers.empty())
+          held -= (held_chunk->buffers.size() - 1) * SIZE + held_chunk->size;
+
+        if (!out->eof)
+          output(held_chunk);
+
+        done = held_chunk->done;
+
+        delete held_chunk;
+      }
+
+      pending.erase(i);
+    }
+  }
+
+  // notify threads waiting in acquire() for their turn
+  std::lock_guard<std::mutex> lock(sync.mutex);
+  sync.turn.notify_all();
+}
+
+// output the buffers or the spilled output of a chunk
+void Output::Writer::output(Chunk *chunk)
+{
+  if (chunk->offset >= 0)
+  {
+    // read the spilled output back from the temporary file in blocks of SIZE bytes
+    if (fseeko(spill_file, chunk->offset, SEEK_SET) != 0)
+    {
+      cancel();
+      return;
+    }
+
+    char *data = buffer.data;
+    size_t size = chunk->size;
+
+    while (size > 0 && !out->eof)
+    {
+      size_t num = size < SIZE ? size : SIZE;
+
+      if (fread(data, 1, num, spill_file) < num)
+      {
+        cancel();
+        return;
+      }
+
+      emit(data, num);
+
+      size -= num;
+    }
+
+    return;
+  }
+
+  if (chunk->buffers.empty())
+    return;
+
+#ifdef WITH_WRITEV
+  if (flag_width == 0)
+  {
+    if (!gather(out->file, chunk->buffers.begin(), std::prev(chunk->buffers.end()), chunk->size))
+      cancel();
+
+    return;
+  }
+#endif
+
+  for (Buffers::iterator i = chunk->buffers.begin(); i != chunk->buffers.end() && !out->eof; ++i)
+    emit(i->data, std::next(i) == chunk->buffers.end() ? chunk->size : SIZE);
+}
+
+// cancel the output of the writer and the threads when the other end closed or on error
+void Output::Writer::cancel()
+{
+  out->eof = true;
+  sync.cancel();
+}
+
+// write a block of output to the output file, or as truncated lines limited to --width columns
+void Output::Writer::emit(const char *data, size_t size)
+{
+  if (size == 0)
+    return;
+
+  if (flag_width == 0)
+  {
+    size_t nwritten = fwrite(data, 1, size, out->file);
+    Stats::score_phase(Stats::OUTPUT, nwritten);
+    if (nwritten < size)
+      cancel();
+  }
+  else
+  {
+    if (out->flush_truncated_lines(data, size))
+      cancel();
+  }
+}
+
+// spill held chunks of the slots output last to the temporary file until the memory held is within --sort-buffer
+void Output::Writer::spill()
+{
+  // keep the chunks in memory when a temporary file cannot be created
+  if (spill_file == NULL)
+  {
+    spill_file = tmpfile();
+    if (spill_file == NULL)
+      return;
+  }
+
+  for (Pending::reverse_iterator i = pending.rbegin(); i != pending.rend() && held > flag_sort_buffer; ++i)
+  {
+    for (auto chunk : i->second)
+    {
+      if (chunk->offset >= 0 || chunk->buffers.empty())
+        continue;
+
+      if (fseeko(spill_file, spill_size, SEEK_SET) != 0)
+        return;
+
+      size_t size = 0;
+
+      for (Buffers::iterator j = chunk->buffers.begin(); j != chunk->buffers.end(); ++j)
+      {
+        size_t num = std::next(j) == chunk->buffers.end() ? chunk->size : SIZE;
+
+        if (fwrite(j->data, 1, num, spill_file) < num)
+          return;
+
+        size += num;
+      }
+
+      held -= size;
+
+      chunk->buffers.clear();
+      chunk->size = size;
+      chunk->offset = spill_size;
+
+      spill_size += size;
+
+      if (held <= flag_sort_buffer)
+        break;
+    }
+  }
+}
+
 // flush a block of data as truncated lines limited to --width columns, taking into account tabs, UTF-8, ANSI
 bool Output::flush_truncated_lines(const char *data, size_t size)
 {
@@ -38,15 +38,30 @@
 #define OUTPUT_HPP
 
 #include "ugrep.hpp"
+#include "stats.hpp"
 #include <reflex/bits.h>
 #include <reflex/utf8.h>
 #include <reflex/matcher.h>
 #include <reflex/fuzzymatcher.h>
 #include <list>
+#include <map>
+#include <vector>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
+#include <atomic>
 #include <cstdint>
 
+// gather the output buffers with writev() on the file descriptor instead of copying the buffers with fwrite()
+#if !defined(OS_WIN_OR_MINGW) && !defined(WITH_NO_WRITEV)
+# define WITH_WRITEV
+#endif
+
+// max number of output buffers gathered per writev()
+#ifndef MAX_IOVEC
+# define MAX_IOVEC 64
+#endif
+
 // max hexadecimal columns of bytes per line = 8*8
 #ifndef MAX_HEX_COLUMNS
 # define MAX_HEX_COLUMNS 64
@@ -71,6 +86,125 @@ class Output {
 
  public:
 
+  // FORMAT strings of --format, --format-open, --format-close, --format-begin, --format-end and --replace compiled once into fields
+  class Format {
+
+   public:
+
+    // a field with the literal text preceding it, the last field has c == '\0' to output the text that ends the FORMAT string
+    struct Field {
+      const char *text;  // literal text preceding the field
+      size_t      size;  // length of the literal text
+      const char *arg;   // %[ARG] argument or NULL
+      size_t      len;   // length of the %[ARG] argument
+      int         width; // %{NUM} width or 0
+      bool        plus;  // %{+NUM} width
+      int         c;     // field character or '\0'
+    };
+
+    typedef std::vector<Field> Fields;
+
+    // compile a FORMAT string into fields, returns false when the FORMAT string has an unterminated %[ARG]
+    static bool compile(const char *format, Fields& fields);
+
+    // compile a FORMAT string once before searching, returns false when the FORMAT string is invalid
+    static bool add(const char *format);
+
+    // remove all compiled FORMAT strings
+    static void clear()
+    {
+      formats.clear();
+    }
+
+    // get the compiled fields of a FORMAT string added before searching, otherwise compile the FORMAT string
+    static const Fields& fields(const char *format);
+
+   protected:
+
+    static std::vector<std::pair<const char*,Fields>> formats; // FORMAT strings compiled before searching
+
+  };
+
+  // --records: FORMAT strings of --format-begin, --format-open, --format and --format-end that output binary records
+  static const char RECORDS_BEGIN[];
+  static const char RECORDS_OPEN[];
+  static const char RECORDS_MATCH[];
+  static const char RECORDS_END[];
+
+  struct Sync;
+
+  // --sort: writer thread that outputs the buffers handed over by threads in slot order, spilling output to a temporary file when exceeding --sort-buffer
+  class Writer {
+
+   public:
+
+    Writer(FILE *file, Sync& sync);
+
+    ~Writer();
+
+    // hand over the buffers up to and including buf with size bytes in buf, never waits for the slot's turn
+    void submit(size_t slot, Buffers& buffers, Buffers::iterator buf, size_t size);
+
+    // mark the slot completed
+    void done(size_t slot);
+
+    // output the remaining slots and wait for the writer thread to terminate
+    void join();
+
+   protected:
+
+    // output of a slot handed over to the writer thread through the completion queue
+    struct Chunk {
+      Chunk   *next;    // next chunk in the completion queue
+      size_t   slot;    // slot of this output
+      Buffers  buffers; // output buffers, the last buffer holds size bytes
+      size_t   size;    // number of bytes in the last buffer or the number of bytes spilled
+      int64_t  offset;  // offset of the output spilled to the temporary file or -1
+      bool     done;    // slot is completed
+      bool     stop;    // stop the writer thread after the remaining chunks are output
+    };
+
+    typedef std::map<size_t,std::list<Chunk*>> Pending; // slots waiting for their turn
+
+    // push a chunk on the lock-free completion queue, wake up the writer thread when it waits
+    void push(Chunk *chunk);
+
+    // pop all chunks from the completion queue in FIFO order, wait when the queue is empty
+    Chunk *pop();
+
+    // the writer thread
+    void run();
+
+    // output a chunk or hold it until its slot's turn, then advance to the next slot when the slot is completed
+    void write(Chunk *chunk);
+
+    // output the buffers or the spilled output of a chunk
+    void output(Chunk *chunk);
+
+    // cancel the output of the writer and the threads when the other end closed or on error
+    void cancel();
+
+    // write a block of output to the output file, or as truncated lines limited to --width columns
+    void emit(const char *data, size_t size);
+
+    // spill held chunks of the slots output last to the temporary file until the memory held is within --sort-buffer
+    void spill();
+
+    Buffer                  buffer;  // buffer to read spilled output back
+    Output                 *out;     // writer's output to write the buffers to the output file or to truncate lines with --width
+    Sync&                   sync;    // sync state with last slot to take turns
+    std::atomic<Chunk*>     queue;   // lock-free LIFO completion queue of chunks handed over by threads
+    std::atomic_bool        waiting; // writer thread waits for chunks
+    std::mutex              mutex;   // mutex for the writer thread to wait for chunks
+    std::condition_variable work;    // cv to wake up the writer thread
+    Pending                 pending; // chunks of slots waiting for their turn
+    size_t                  held;    // number of bytes of pending chunks held in memory
+    FILE                   *spill_file; // temporary file with spilled output or NULL
+    int64_t                 spill_size; // size of the temporary file
+    std::thread             thread;  // the writer thread
+
+  };
+
   // sync state to synchronize output produced by multiple threads, UNORDERED or ORDERED by slot number
   struct Sync {
 
@@ -84,9 +218,33 @@ class Output {
         next(0),
         last(0),
         bits_mutex(),
-        completed()
+        completed(),
+        writer(NULL)
     { }
 
+    ~Sync()
+    {
+      stop_writer();
+    }
+
+    // --sort: start the writer thread to output the buffers handed over by threads in slot order
+    void start_writer(FILE *file)
+    {
+      if (mode == Mode::ORDERED && writer == NULL)
+        writer = new Writer(file, *this);
+    }
+
+    // --sort: output the remaining slots and stop the writer thread
+    void stop_writer()
+    {
+      if (writer != NULL)
+      {
+        writer->join();
+        delete writer;
+        writer = NULL;
+      }
+    }
+
     // acquire output access
     void acquire(std::unique_lock<std::mutex> *lock, size_t slot)
     {
@@ -94,17 +252,31 @@ class Output {
       {
         case Mode::UNORDERED:
           // if lock is not already acquired, acquire the lock
-          if (!lock->owns_lock())
+          if (!lock->owns_lock() && !lock->try_lock())
+          {
+            // --stats=phases: time waiting for the lock
+            Stats::Timer timer(Stats::WAIT);
+            Stats::score_phase(Stats::WAIT, 1);
+
             lock->lock();
+          }
           break;
 
         case Mode::ORDERED:
           // if lock is not already acquired, wait for our turn to acquire the lock
           if (!lock->owns_lock())
           {
+            // --stats=phases: time waiting for the lock and our turn
+            Stats::Timer timer(Stats::WAIT);
+
             lock->lock();
-            while (last != STOP && slot != last)
-              turn.wait(*lock);
+            if (last != STOP && slot != last)
+            {
+              Stats::score_phase(Stats::WAIT, 1);
+
+              while (last != STOP && slot != last)
+                turn.wait(*lock);
+            }
           }
           break;
       }
@@ -120,8 +292,8 @@ class Output {
           return lock->owns_lock() || lock->try_lock();
 
         case Mode::ORDERED:
-          // lock is owned
-          return lock->owns_lock();
+          // lock is owned or the writer thread outputs the buffers handed over
+          return lock->owns_lock() || writer != NULL;
       }
 
       return false;
@@ -153,6 +325,16 @@ class Output {
 
         case Mode::ORDERED:
         {
+          // the writer thread bumps last to allow next turn when all output of the slot is written
+          if (writer != NULL)
+          {
+            if (lock->owns_lock())
+              lock->unlock();
+
+            writer->done(slot);
+            break;
+          }
+
           // if this is our slot, bump last to allow next turn, release lock, and notify other threads
           std::unique_lock<std::mutex> lock_bits(bits_mutex);
 
@@ -225,6 +407,7 @@ class Output {
     std::atomic_size_t           last;       // ORDERED: slot for threads to wait for their turn to output, or STOP to cancel
     std::mutex                   bits_mutex; // ORDERED: mutex to synchronize bitset access and when setting last = STOP
     reflex::Bits                 completed;  // ORDERED: bitset of completed slots marked by release() by threads that don't acquire() output
+    Writer                      *writer;     // ORDERED: writer thread to output the buffers handed over by threads or NULL
 
   };
 
@@ -319,6 +502,7 @@ class Output {
       lock_(NULL),
       slot_(0),
       lineno_(0),
+      id_(0),
       mode_(flag_line_buffered ? FLUSH : 0),
       cols_(0),
       ansi_(ANSI::NA),
@@ -652,6 +836,17 @@ class Output {
     str(&tmp[k], n);
   }
 
+  // output a 64-bit unsigned integer i in little-endian binary
+  inline void u64(uint64_t i)
+  {
+    char tmp[8];
+
+    for (int k = 0; k < 8; ++k, i >>= 8)
+      tmp[k] = static_cast<char>(i & 0xff);
+
+    str(tmp, 8);
+  }
+
   // output a number in hex with width w (padded with digit '0')
   inline void hex(size_t i, int w = 0)
   {
@@ -855,6 +1050,15 @@ class Output {
   // output formatted inverted match with options -v --format, --format-open, --format-close
   void format_invert(const char *format, const char *pathname, const std::string& partname, size_t matches, size_t lineno, size_t offset, const char *ptr, size_t size, bool& heading, bool next);
 
+  // output --records binary record of the given type and payload size, followed by the payload
+  void record(int type, uint64_t size)
+  {
+    u64(size << 8 | static_cast<uint64_t>(type));
+  }
+
+  // output --records binary match record or count record
+  void record_match(size_t matches, reflex::AbstractMatcher *matcher);
+
   // output a quoted string with escapes for \ and "
   void quote(const char *data, size_t size);
 
@@ -882,40 +1086,35 @@ class Output {
     {
       if (!eof)
       {
-        // if multi-threaded and lock is not already owned, then lock on master's mutex
-        acquire();
-
         // --null-data: swap NUL with LF in the output by converting these characters in the output buffers
         if (flag_null_data)
+          swap_null_data();
+
+        // --sort: hand the buffers over to the writer thread
+        if (sync != NULL && sync->writer != NULL)
         {
-          for (Buffers::iterator i = buffers_.begin(); i != buf_; ++i)
-          {
-            char *data = i->data;
+          hand_over();
+          return;
+        }
 
-            for (size_t k = 0; k < SIZE; ++k)
-            {
-              if (data[k] == '\0')
-                data[k] = '\n';
-              else if (data[k] == '\n')
-                data[k] = '\0';
-            }
-          }
+        // --stats=phases: time writing output, excluding the time waiting for the lock
+        Stats::Timer timer(Stats::OUTPUT);
 
-          size_t num = cur_ - buf_->data;
+        // if multi-threaded and lock is not already owned, then lock on master's mutex
+        acquire();
 
-          if (num > 0)
-          {
-            char *data = buf_->data;
+#ifdef WITH_WRITEV
+        // gather the buffers container to write to the designated output file, pipe, or stream, except --width lines are truncated
+        if (flag_width == 0)
+        {
+          if (!gather(file, buffers_.begin(), buf_, cur_ - buf_->data))
+            cancel();
 
-            for (size_t k = 0; k < num; ++k)
-            {
-              if (data[k] == '\0')
-                data[k] = '\n';
-              else if (data[k] == '\n')
-                data[k] = '\0';
-            }
-          }
+          buf_ = buffers_.begin();
+          cur_ = buf_->data;
+          return;
         }
+#endif
 
         // flush the buffers container to the designated output file, pipe, or stream
         for (Buffers::iterator i = buffers_.begin(); i != buf_; ++i)
@@ -923,6 +1122,7 @@ class Output {
           if (flag_width == 0)
           {
             size_t nwritten = fwrite(i->data, 1, SIZE, file);
+            Stats::score_phase(Stats::OUTPUT, nwritten);
             if (nwritten < SIZE)
             {
               cancel();
@@ -948,6 +1148,7 @@ class Output {
             if (flag_width == 0)
             {
               size_t nwritten = fwrite(buf_->data, 1, num, file);
+              Stats::score_phase(Stats::OUTPUT, nwritten);
               if (nwritten < num)
                 cancel();
             }
@@ -968,6 +1169,17 @@ class Output {
     }
   }
 
+  // --sort: hand the buffers over to the writer thread to output in slot order
+  void hand_over();
+
+#ifdef WITH_WRITEV
+  // write the buffers from i up to buf and num bytes in buf to the file with writev(), returns false on error
+  static bool gather(FILE *file, Buffers::iterator i, Buffers::iterator buf, size_t num);
+#endif
+
+  // swap NUL with LF in the output buffers for --null-data
+  void swap_null_data();
+
   // flush a block of data as truncated lines limited to --width columns
   bool flush_truncated_lines(const char *data, size_t size);
 
@@ -1010,6 +1222,7 @@ class Output {
   std::unique_lock<std::mutex> *lock_;    // synchronization lock
   size_t                        slot_;    // current slot to take turns
   size_t                        lineno_;  // last line number matched, when --format field %u (unique) is used
+  size_t                        id_;      // --records file id of the file or part searched
   Buffers                       buffers_; // buffers container
   Buffers::iterator             buf_;     // current buffer in the container
   char                         *cur_;     // current position in the current buffer
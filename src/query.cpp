@@ -45,6 +45,10 @@
 #include <chrono>
 #include <fcntl.h>
 
+#if defined(OS_WIN)
+# define fseeko _fseeki64
+#endif
+
 #ifdef OS_WIN_OR_MINGW
 
 #include <direct.h>
@@ -929,6 +933,7 @@ void Query::query_ui()
   tick_ = 4;
   row_ = 0;
   rows_ = 0;
+  view_.clear();
   maxrows_ = Screen::rows;
   skip_ = 0;
   select_ = -1;
@@ -1503,6 +1508,10 @@ void Query::search()
     search_thread_.join();
   }
 
+  // the files that matched a cancelled search are incomplete and cannot narrow the search of a refined query
+  if (cancel)
+    Static::selected.searched = false;
+
 #ifdef OS_WIN_OR_MINGW
 
   hPipe_ = nonblocking_pipe(search_pipe_);
@@ -1535,6 +1544,7 @@ void Query::search()
   append_ = false;
   row_ = 0;
   rows_ = 0;
+  view_.clear();
   skip_ = 0;
   searched_ = 0;
   found_ = 0;
@@ -1884,18 +1894,15 @@ bool Query::fetch(int row)
 
     if (nlptr != NULL)
     {
-      // allocate more rows on demand
-      if (rows_ >= static_cast<int>(view_.size()))
-      {
-        view_.emplace_back();
+      // allocate more selection flags on demand
+      if (rows_ >= static_cast<int>(selected_.size()))
         selected_.push_back(select_all_);
-      }
 
-      // assign or append the row from the buffer
+      // add or append the row from the buffer
       if (append_)
-        view_[rows_].append(buffer_, nlptr - buffer_);
+        view_.append(buffer_, nlptr - buffer_);
       else
-        view_[rows_].assign(buffer_, nlptr - buffer_);
+        view_.add(buffer_, nlptr - buffer_);
 
       // this row is selected if select all is set
       selected_[rows_] = select_all_;
@@ -1904,8 +1911,7 @@ bool Query::fetch(int row)
       if (!incomplete)
       {
         // added another row
-        if (++rows_ < static_cast<int>(view_.size()))
-          view_[rows_].clear();
+        ++rows_;
 
         // skip \n
         if (nlptr < buffer_ + buflen_)
@@ -2155,7 +2161,7 @@ void Query::back()
     {
       do
         --ref;
-      while (ref > 0 && view_[ref].size() > 1);
+      while (ref > 0 && view_.length(ref) > 1);
     }
   }
   else
@@ -2175,7 +2181,7 @@ void Query::back()
       ++ref;
 
       // --tree: skip over directory tree spacing
-      if (compare_dir && flag_tree && (view_[ref].empty() || view_[ref].front() != '\0'))
+      if (compare_dir && flag_tree && (view_.length(ref) == 0 || view_.front(ref) != '\0'))
         ++ref;
     }
   }
@@ -2207,7 +2213,7 @@ void Query::next()
     {
       bool found = false;
 
-      while (ref + 1 < rows_ && !(found = view_[ref].size() <= 1))
+      while (ref + 1 < rows_ && !(found = view_.length(ref) <= 1))
         ++ref;
 
       redraw();
@@ -2414,18 +2420,18 @@ void Query::view()
     if (flag_tree && (flag_files_with_matches || flag_count))
     {
       // --tree with -c or -l: move down over non-filename lines to reach a filename
-      while (ref + 1 < rows_ && (view_[ref].empty() || view_[ref].front() != '\0'))
+      while (ref + 1 < rows_ && (view_.length(ref) == 0 || view_.front(ref) != '\0'))
         ++ref;
     }
     else
     {
       // move down to skip empty lines
-      while (ref + 1 < rows_ && view_[ref].empty())
+      while (ref + 1 < rows_ && view_.length(ref) == 0)
         ++ref;
     }
 
     // move up until a filename header is found, unless we're at an empty line
-    if (!view_[ref].empty())
+    if (view_.length(ref) > 0)
       while (ref >= 0 && !(found = find_filename(ref, filename, false, true, &partname)))
         --ref;
 
@@ -2698,11 +2704,11 @@ void Query::preview()
 
     // --tree with -c or -l: move down over non-filename lines to reach a filename
     if (flag_tree && (flag_files_with_matches || flag_count))
-      while (ref + 1 < rows_ && (view_[ref].empty() || view_[ref].front() != '\0'))
+      while (ref + 1 < rows_ && (view_.length(ref) == 0 || view_.front(ref) != '\0'))
         ++ref;
 
     // find a filename upwards, unless we're at an empty line
-    if (!view_[ref].empty())
+    if (view_.length(ref) > 0)
       while (ref >= 0 && !(found = find_filename(ref, filename, false, true, &partname)))
         --ref;
 
@@ -2816,13 +2822,13 @@ void Query::select()
   // --tree: move down over non-filename lines to reach a filename
   if (flag_tree && (flag_files_with_matches || flag_count))
   {
-    while (ref + 1 < rows_ && (view_[ref].empty() || view_[ref].front() != '\0'))
+    while (ref + 1 < rows_ && (view_.length(ref) == 0 || view_.front(ref) != '\0'))
       ++ref;
   }
   else
   {
     // move down to skip empty lines
-    while (ref + 1 < rows_ && view_[ref].empty())
+    while (ref + 1 < rows_ && view_.length(ref) == 0)
       ++ref;
   }
 
@@ -3695,6 +3701,137 @@ void Query::meta(int key)
   Screen::alert();
 }
 
+// remove all rows
+void Query::View::clear()
+{
+  for (auto chunk : chunks)
+    delete[] chunk;
+
+  chunks.clear();
+  rows.clear();
+  end = 0;
+  held = 0;
+  spilled = 0;
+
+  // the chunk read back into the cache is no longer valid
+  delete[] cache;
+  cache = NULL;
+}
+
+// the first char of a row or \0 when the row is empty or not stored
+char Query::View::front(int row)
+{
+  if (length(row) == 0)
+    return '\0';
+
+  uint64_t offset = rows[row];
+
+  return chunk(static_cast<size_t>(offset / QUERY_VIEW_CHUNK))[offset % QUERY_VIEW_CHUNK];
+}
+
+// the text of a row, read back from the temporary file when spilled
+std::string Query::View::operator[](int row)
+{
+  std::string text;
+
+  size_t size = length(row);
+
+  if (size == 0)
+    return text;
+
+  text.reserve(size);
+
+  uint64_t offset = rows[row];
+
+  while (size > 0)
+  {
+    size_t pos = static_cast<size_t>(offset % QUERY_VIEW_CHUNK);
+    size_t num = std::min(size, QUERY_VIEW_CHUNK - pos);
+
+    text.append(chunk(static_cast<size_t>(offset / QUERY_VIEW_CHUNK)) + pos, num);
+
+    offset += num;
+    size -= num;
+  }
+
+  return text;
+}
+
+// write text to the end of the last row
+void Query::View::write(const char *text, size_t size)
+{
+  while (size > 0)
+  {
+    size_t index = static_cast<size_t>(end / QUERY_VIEW_CHUNK);
+    size_t pos = static_cast<size_t>(end % QUERY_VIEW_CHUNK);
+
+    // allocate a new chunk when the last chunk is full
+    if (index >= chunks.size())
+    {
+      chunks.push_back(new char[QUERY_VIEW_CHUNK]);
+      ++held;
+
+      spill();
+    }
+
+    size_t num = std::min(size, QUERY_VIEW_CHUNK - pos);
+
+    memcpy(chunks[index] + pos, text, num);
+
+    text += num;
+    size -= num;
+    end += num;
+  }
+}
+
+// spill the chunks stored first to the temporary file until the chunks held in memory are within QUERY_VIEW_MEMORY
+void Query::View::spill()
+{
+  // keep the last chunk in memory to write to
+  while (static_cast<uint64_t>(held) * QUERY_VIEW_CHUNK > QUERY_VIEW_MEMORY && spilled + 1 < chunks.size())
+  {
+    // keep the chunks in memory when a temporary file cannot be created
+    if (file == NULL)
+    {
+      file = tmpfile();
+      if (file == NULL)
+        return;
+    }
+
+    if (fseeko(file, static_cast<int64_t>(spilled) * QUERY_VIEW_CHUNK, SEEK_SET) != 0 ||
+        fwrite(chunks[spilled], 1, QUERY_VIEW_CHUNK, file) < QUERY_VIEW_CHUNK)
+      return;
+
+    delete[] chunks[spilled];
+    chunks[spilled] = NULL;
+
+    --held;
+    ++spilled;
+  }
+}
+
+// the chunk of text with the given index, read back from the temporary file when spilled
+const char *Query::View::chunk(size_t index)
+{
+  if (chunks[index] != NULL)
+    return chunks[index];
+
+  if (cache == NULL || cached != index)
+  {
+    if (cache == NULL)
+      cache = new char[QUERY_VIEW_CHUNK];
+
+    cached = index;
+
+    // the chunk is lost when it cannot be read back, show it as spaces
+    if (fseeko(file, static_cast<int64_t>(index) * QUERY_VIEW_CHUNK, SEEK_SET) != 0 ||
+        fread(cache, 1, QUERY_VIEW_CHUNK, file) < QUERY_VIEW_CHUNK)
+      memset(cache, ' ', QUERY_VIEW_CHUNK);
+  }
+
+  return cache;
+}
+
 // true if at least one line is selected
 bool Query::selections()
 {
@@ -3719,7 +3856,6 @@ void Query::print()
     if (selected_[i])
       if (!print(view_[i]))
         return;
-    view_[i].clear();
     ++i;
   }
 
@@ -3738,7 +3874,10 @@ void Query::print()
     {
       // if not appending to a row, start over at the begin of the view to conserve memory
       if (!append_)
+      {
         rows_ = 0;
+        view_.clear();
+      }
 
       i = rows_;
 
@@ -3749,7 +3888,6 @@ void Query::print()
       {
         if (!print(view_[i]))
           return;
-        view_[i].clear();
         ++i;
       }
     }
@@ -4326,7 +4464,7 @@ bool Query::find_filename(int ref, std::string& filename, bool compare_dir, bool
     // while the top directory was not found (works since no colors are used for directory names)
     while (start > 2 && --ref >= 0)
     {
-      if (view_[ref].size() <= 1)
+      if (view_.length(ref) <= 1)
         break;
 
       if (!get_filename(ref, dir, start, pos))
@@ -4486,7 +4624,7 @@ std::string                Query::selected_file_;
 std::stack<Query::History> Query::history_;
 std::vector<const char*>   Query::files_;
 int                        Query::skip_                = 0;
-std::vector<std::string>   Query::view_;
+Query::View                Query::view_;
 std::vector<bool>          Query::selected_;
 bool                       Query::eof_                 = true;
 bool                       Query::append_              = false;
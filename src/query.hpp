@@ -56,6 +56,16 @@
 #define QUERY_BUFFER_SIZE 16384
 #endif
 
+// size of the chunks of memory that store the search output rows to display
+#ifndef QUERY_VIEW_CHUNK
+#define QUERY_VIEW_CHUNK 1048576
+#endif
+
+// max memory to store the search output rows to display, chunks are spilled to a temporary file when exceeded
+#ifndef QUERY_VIEW_MEMORY
+#define QUERY_VIEW_MEMORY 67108864
+#endif
+
 // default -Q response to keyboard input delay is 3 for 300ms, in steps of 100ms
 #ifndef DEFAULT_QUERY_DELAY
 #define DEFAULT_QUERY_DELAY 3
@@ -165,6 +175,88 @@ class Query {
 
   };
 
+  // search output rows to display, stored back to back in chunks of memory with an offset index, spilling chunks to a temporary file when exceeding QUERY_VIEW_MEMORY
+  class View {
+
+   public:
+
+    View()
+      :
+        end(0),
+        held(0),
+        spilled(0),
+        file(NULL),
+        cache(NULL),
+        cached(0)
+    { }
+
+    ~View()
+    {
+      clear();
+      if (file != NULL)
+        fclose(file);
+      delete[] cache;
+    }
+
+    // remove all rows
+    void clear();
+
+    // number of rows stored, including the last incomplete row
+    int size() const
+    {
+      return static_cast<int>(rows.size());
+    }
+
+    // add a row of text
+    void add(const char *text, size_t size)
+    {
+      rows.push_back(end);
+      write(text, size);
+    }
+
+    // append text to the last row
+    void append(const char *text, size_t size)
+    {
+      write(text, size);
+    }
+
+    // the length of a row, zero when the row is not stored
+    size_t length(int row) const
+    {
+      if (row < 0 || static_cast<size_t>(row) >= rows.size())
+        return 0;
+
+      return static_cast<size_t>((static_cast<size_t>(row) + 1 < rows.size() ? rows[row + 1] : end) - rows[row]);
+    }
+
+    // the first char of a row or \0 when the row is empty or not stored
+    char front(int row);
+
+    // the text of a row, read back from the temporary file when spilled
+    std::string operator[](int row);
+
+   protected:
+
+    // write text to the end of the last row
+    void write(const char *text, size_t size);
+
+    // spill the chunks stored first to the temporary file until the chunks held in memory are within QUERY_VIEW_MEMORY
+    void spill();
+
+    // the chunk of text with the given index, read back from the temporary file when spilled
+    const char *chunk(size_t index);
+
+    std::vector<uint64_t> rows;    // offset of each row in the text
+    uint64_t              end;     // end of the text
+    std::vector<char*>    chunks;  // chunks of QUERY_VIEW_CHUNK bytes of text, NULL when spilled
+    size_t                held;    // number of chunks held in memory
+    size_t                spilled; // number of chunks spilled, the chunks stored first
+    FILE                 *file;    // temporary file with the chunks spilled or NULL
+    char                 *cache;   // a chunk read back from the temporary file or NULL
+    size_t                cached;  // index of the chunk read back into the cache
+
+  };
+
   static void query_ui();
 
   static char *line_ptr(int col);
@@ -308,7 +400,7 @@ class Query {
   static std::string              selected_file_;
   static std::stack<History>      history_;     // tabbing history
   static std::vector<const char*> files_;       // saved arg_files command line FILEs to search
-  static std::vector<std::string> view_;        // search output text to display, incrementally fetched
+  static View                     view_;        // search output text to display, incrementally fetched
   static std::vector<bool>        selected_;    // marked lines in view_[] selected in selection mode
   static bool                     eof_;         // end of results, no more results can be fetched
   static bool                     append_;      // flag to append search output to the last incomplete line
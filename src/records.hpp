@@ -0,0 +1,289 @@
+/******************************************************************************\
+* Copyright (c) 2019, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      records.hpp
+@brief     --records binary match records and a reference reader
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2019-2025, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+
+Option --records outputs a stream of binary records.  Each record starts with a
+64-bit little-endian word with the record type in the low 8 bits and the size
+of the payload in bytes in the upper 56 bits.  The payload consists of 64-bit
+little-endian integers followed by raw bytes, nothing is escaped:
+
+  'H' header: version
+  'F' file:   id, pathname size, partname size, pathname, partname
+  'M' match:  id, line number, column number, offset, size, text offset, text
+  'L' line:   id, line number, column number, offset, size, text offset, text
+  'C' count:  id, count
+  'E' end:    number of files
+
+The stream starts with a 'H' record and ends with an 'E' record.  A 'F' record
+assigns a file id to a pathname and a partname (an archive part or empty) and
+precedes the 'M', 'L' and 'C' records with this id.  File ids are numbered 1,
+2, 3 and so on, a file id is at most the number of preceding 'F' records + 1.
+A 'M' record is a match at the given byte offset and size in bytes, with the
+text of the matching line (or lines when the match spans multiple lines)
+starting at the given text offset, or the text of the match itself with option
+-o.  A 'L' record is a non-matching line with option -v.  A 'C' record is the
+count of option -c.  The text is empty with --records=spans.  The reader
+rejects a record with a payload larger than RecordReader::MAX_SIZE as
+malformed.
+
+Records are read by the reference reader in this file, which is self-contained
+so that it can be copied into other projects:
+
+  RecordReader reader(stdin);
+  RecordReader::Record record;
+  while (reader.next(record))
+    if (record.type == RecordReader::MATCH)
+      printf("%s:%llu\n", reader.pathname(record.id).c_str(), record.lineno);
+
+*/
+
+#ifndef RECORDS_HPP
+#define RECORDS_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --records binary record reader
+class RecordReader {
+
+ public:
+
+  // record format version
+  static const uint64_t FORMAT_VERSION = 1;
+
+  // maximum payload size of a record accepted by the reader, a larger size is malformed
+  static const uint64_t MAX_SIZE = 1ULL << 30;
+
+  // record types
+  static const int HEADER   = 'H';
+  static const int PATHNAME = 'F';
+  static const int MATCH    = 'M';
+  static const int LINE     = 'L';
+  static const int COUNT    = 'C';
+  static const int END      = 'E';
+
+  // a record, the text points into the reader's buffer and is valid until the next record is read
+  struct Record {
+    int         type;        // record type
+    uint64_t    id;          // file id of 'F', 'M', 'L' and 'C' records
+    uint64_t    lineno;      // line number of 'M' and 'L' records
+    uint64_t    columno;     // column number of 'M' and 'L' records
+    uint64_t    offset;      // byte offset of the match or line of 'M' and 'L' records
+    uint64_t    size;        // size of the match or line of 'M' and 'L' records
+    uint64_t    text_offset; // byte offset of the text of 'M' and 'L' records
+    uint64_t    count;       // version of 'H', count of 'C' and number of files of 'E' records
+    const char *text;        // text of 'M' and 'L' records, pathname of 'F' records
+    size_t      text_size;   // size of the text
+    const char *part;        // partname of 'F' records
+    size_t      part_size;   // size of the partname
+  };
+
+  RecordReader(FILE *file, size_t size = 262144)
+    :
+      file_(file),
+      buf_(size < 64 ? 64 : size),
+      pos_(0),
+      len_(0),
+      error_(false),
+      files_seen_(0)
+  { }
+
+  // read the next record, returns false at the end of the stream or when an error occurred
+  bool next(Record& record)
+  {
+    if (!fill(8))
+      return false;
+
+    uint64_t word = get(&buf_[pos_]);
+    uint64_t size = word >> 8;
+
+    if (size > MAX_SIZE || !fill(static_cast<size_t>(8 + size)))
+      return error_ = true, false;
+
+    const char *p = &buf_[pos_ + 8];
+    const char *e = p + size;
+
+    memset(&record, 0, sizeof(record));
+    record.type = static_cast<int>(word & 0xff);
+
+    pos_ += static_cast<size_t>(8 + size);
+
+    switch (record.type)
+    {
+      case HEADER:
+        if (size < 8)
+          break;
+        record.count = get(p);
+        return true;
+
+      case PATHNAME:
+        if (size < 24)
+          break;
+        record.id = get(p);
+        record.text_size = static_cast<size_t>(get(p + 8));
+        record.part_size = static_cast<size_t>(get(p + 16));
+        if (record.text_size > size - 24 || record.part_size > size - 24 - record.text_size)
+          break;
+        // reject a file id that is not at most the number of file records seen + 1, to bound the files_ allocation
+        if (record.id > files_seen_ + 1)
+          break;
+        ++files_seen_;
+        record.text = p + 24;
+        record.part = record.text + record.text_size;
+        if (files_.size() <= record.id)
+          files_.resize(record.id + 1);
+        files_[record.id].first.assign(record.text, record.text_size);
+        files_[record.id].second.assign(record.part, record.part_size);
+        return true;
+
+      case MATCH:
+      case LINE:
+        if (size < 48)
+          break;
+        record.id = get(p);
+        record.lineno = get(p + 8);
+        record.columno = get(p + 16);
+        record.offset = get(p + 24);
+        record.size = get(p + 32);
+        record.text_offset = get(p + 40);
+        record.text = p + 48;
+        record.text_size = e - record.text;
+        return true;
+
+      case COUNT:
+        if (size < 16)
+          break;
+        record.id = get(p);
+        record.count = get(p + 8);
+        return true;
+
+      case END:
+        if (size < 8)
+          break;
+        record.count = get(p);
+        return true;
+
+      default:
+        // skip unknown record types added by later versions
+        return true;
+    }
+
+    error_ = true;
+
+    return false;
+  }
+
+  // the pathname of a file id
+  const std::string& pathname(uint64_t id) const
+  {
+    return id < files_.size() ? files_[id].first : empty_;
+  }
+
+  // the partname of a file id, empty when the file is not an archive part
+  const std::string& partname(uint64_t id) const
+  {
+    return id < files_.size() ? files_[id].second : empty_;
+  }
+
+  // true if the stream is truncated or malformed
+  bool error() const
+  {
+    return error_ || (file_ != NULL && ferror(file_));
+  }
+
+ protected:
+
+  // decode a 64-bit little-endian integer
+  static uint64_t get(const char *p)
+  {
+    const unsigned char *q = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint64_t>(q[0])       | static_cast<uint64_t>(q[1]) << 8  |
+           static_cast<uint64_t>(q[2]) << 16 | static_cast<uint64_t>(q[3]) << 24 |
+           static_cast<uint64_t>(q[4]) << 32 | static_cast<uint64_t>(q[5]) << 40 |
+           static_cast<uint64_t>(q[6]) << 48 | static_cast<uint64_t>(q[7]) << 56;
+  }
+
+  // make sure the buffer holds at least size bytes at pos_, returns false at the end of the stream
+  bool fill(size_t size)
+  {
+    if (len_ - pos_ >= size)
+      return true;
+
+    if (pos_ > 0)
+    {
+      memmove(&buf_[0], &buf_[pos_], len_ - pos_);
+      len_ -= pos_;
+      pos_ = 0;
+    }
+
+    if (size > 8 + MAX_SIZE)
+    {
+      error_ = true;
+      return false;
+    }
+
+    if (buf_.size() < size)
+      buf_.resize(size);
+
+    while (len_ < size)
+    {
+      size_t n = fread(&buf_[len_], 1, buf_.size() - len_, file_);
+      if (n == 0)
+        break;
+      len_ += n;
+    }
+
+    if (len_ < size && len_ > 0)
+      error_ = true;
+
+    return len_ >= size;
+  }
+
+  typedef std::vector< std::pair<std::string,std::string> > Files;
+
+  FILE             *file_;       // input stream
+  std::vector<char> buf_;        // input buffer
+  size_t            pos_;        // position of the next record in the buffer
+  size_t            len_;        // number of bytes in the buffer
+  bool              error_;      // truncated or malformed stream
+  Files             files_;      // pathnames and partnames indexed by file id
+  uint64_t          files_seen_; // number of file records read
+  std::string       empty_;      // empty pathname of an unknown file id
+
+};
+
+#endif
@@ -51,13 +51,16 @@ void Stats::report(FILE *output)
   size_t ff = found_files();
   size_t fp = found_parts();
   size_t fm = found_matches();
+  size_t sb = searched_bytes();
+  size_t cb = cached_bytes();
   size_t ws = Static::warnings;
+  float ms = reflex::timer_elapsed(timer);
 
   fprintf(output, NEWLINESTR "Searched %zu file%s", sf, (sf == 1 ? "" : "s"));
   if (sd > 0)
     fprintf(output, " in %zu director%s", sd, (sd == 1 ? "y" : "ies"));
   if (!flag_query && flag_pager == NULL)
-    fprintf(output, " in %.3g seconds", 0.001 * reflex::timer_elapsed(timer));
+    fprintf(output, " in %.3g seconds", 0.001 * ms);
   if (Static::threads > 1)
     fprintf(output, " with %zu threads", Static::threads);
   fprintf(output, ": %zu matching (%.4g%%)", ff, 100.0 * ff / sf);
@@ -73,6 +76,20 @@ void Stats::report(FILE *output)
       fprintf(output, "Searched %zu line%s: %zu matching (%.4g%%)" NEWLINESTR, sl, (sl == 1 ? "" : "s"), fm, 100.0 * fm / sl);
   }
 
+  if (sb > 0)
+  {
+    fprintf(output, "Read %zu byte%s", sb, (sb == 1 ? "" : "s"));
+    if (!flag_query && flag_pager == NULL)
+      fprintf(output, " at %.4g MB/s", 0.001 * sb / std::max(ms, 0.001f));
+    if (flag_read_order_key != Order::NA && flag_sort_key == Sort::NA)
+      fprintf(output, " in %s order", flag_read_order);
+    fprintf(output, ": left %zu KB of file pages resident in the page cache" NEWLINESTR, cb / 1024);
+  }
+  else if (flag_read_order_key != Order::NA && flag_sort_key == Sort::NA)
+  {
+    fprintf(output, "Read files in %s order" NEWLINESTR, flag_read_order);
+  }
+
   if (flag_index && indexed > 0)
   {
     fprintf(output, "Skipped %zu file%s of %zu (%.4g%%) not matching %zu indexes\n", ss, (ss == 1 ? "" : "s"), sf - ff, 100.0 * ss / (sf - ff), si);
@@ -90,6 +107,14 @@ void Stats::report(FILE *output)
     }
   }
 
+  if (flag_cache != NULL)
+  {
+    size_t ch = cached_hits();
+    size_t cm = cached_misses();
+    size_t ci = cached_invalidated();
+    fprintf(output, "Skipped %zu file%s of %zu (%.4g%%) not matching in %s: %zu cache miss%s and %zu invalidated" NEWLINESTR, ch, (ch == 1 ? "" : "s"), sf - ff, sf > ff ? 100.0 * ch / (sf - ff) : 0.0, flag_cache, cm, (cm == 1 ? "" : "es"), ci);
+  }
+
   if (Static::warnings > 0)
     fprintf(output, "Received %zu warning%s" NEWLINESTR, ws, ws == 1 ? "" : "s");
 
@@ -203,6 +228,107 @@ void Stats::report(FILE *output)
     fprintf(output, "  --exclude-dir=\"%s\"%s%s" NEWLINESTR, i.c_str(), i.front() == '!' ? " (negated)" : "", &i < &flag_all_exclude_dir.front() + flag_exclude_iglob_dir_size ? " (ignore case)" : "");
 }
 
+// the name of a phase
+const char *Stats::phase_name(int phase)
+{
+  static const char *names[PHASES] = { "none", "traverse", "select", "read", "decompress", "match", "cnf", "output", "wait" };
+
+  return names[phase];
+}
+
+// true if the amount of a phase is in bytes, otherwise the amount is a number of directory entries, pathnames, files, lines or waits
+static bool phase_bytes(int phase)
+{
+  return phase == Stats::DECOMPRESS || phase == Stats::MATCH || phase == Stats::OUTPUT;
+}
+
+// --stats=phases: report the time spent and the throughput per phase
+void Stats::report_phases(FILE *output)
+{
+  static const char *units[PHASES] = { "", "directory entries", "pathnames", "files", "bytes", "bytes", "lines", "bytes", "waits" };
+
+  double total = 0.0;
+  for (int i = NONE + 1; i < PHASES; ++i)
+    total += 1e-9 * phase_time[i];
+
+  fprintf(output, "Spent %.3g seconds in %zu thread%s:" NEWLINESTR, total, Static::threads, Static::threads == 1 ? "" : "s");
+
+  for (int i = NONE + 1; i < PHASES; ++i)
+  {
+    double sec = 1e-9 * phase_time[i];
+    size_t amount = phase_amount[i];
+
+    fprintf(output, "  %-10s %10.3fms %5.1f%% %14zu %s", phase_name(i), 1000.0 * sec, total > 0.0 ? 100.0 * sec / total : 0.0, amount, units[i]);
+    if (phase_bytes(i) && amount > 0 && sec > 0.0)
+      fprintf(output, " at %.4g MB/s", 1e-6 * amount / sec);
+    fprintf(output, NEWLINESTR);
+  }
+}
+
+// --stats=json: report the statistics and the phases in JSON
+void Stats::report_json(FILE *output)
+{
+  fprintf(output,
+      "{\n"
+      "  \"files\": %zu,\n"
+      "  \"directories\": %zu,\n"
+      "  \"matching_files\": %zu,\n"
+      "  \"matching_parts\": %zu,\n"
+      "  \"lines\": %zu,\n"
+      "  \"matches\": %zu,\n"
+      "  \"bytes_read\": %zu,\n"
+      "  \"seconds\": %.6f,\n"
+      "  \"threads\": %zu,\n"
+      "  \"warnings\": %zu,\n",
+      searched_files(),
+      searched_dirs(),
+      found_files(),
+      found_parts(),
+      searched_lines(),
+      found_matches(),
+      searched_bytes(),
+      0.001 * reflex::timer_elapsed(timer),
+      Static::threads,
+      static_cast<size_t>(Static::warnings));
+
+  if (flag_cache != NULL)
+    fprintf(output, "  \"cache\": { \"hits\": %zu, \"misses\": %zu, \"invalidated\": %zu },\n", cached_hits(), cached_misses(), cached_invalidated());
+
+  fprintf(output, "  \"phases\": {");
+
+  for (int i = NONE + 1; i < PHASES; ++i)
+  {
+    double sec = 1e-9 * phase_time[i];
+    size_t amount = phase_amount[i];
+
+    fprintf(output, "%s\n    \"%s\": { \"seconds\": %.6f, ", i > NONE + 1 ? "," : "", phase_name(i), sec);
+    if (phase_bytes(i))
+      fprintf(output, "\"bytes\": %zu, \"bytes_per_second\": %.0f }", amount, sec > 0.0 ? amount / sec : 0.0);
+    else
+      fprintf(output, "\"count\": %zu }", amount);
+  }
+
+  fprintf(output, "\n  }\n}\n");
+}
+
+#if defined(WITH_MATCHER_STATS)
+// --stats=vm: report the search method counters
+void Stats::report_advance(FILE *output)
+{
+  const char *method = advance_method;
+  size_t skipped = advance_skipped;
+  size_t candidates = advance_candidates;
+  size_t verified = advance_verified;
+  size_t matches = advance_matches;
+
+  fprintf(output, "Search: %s skipped %zu bytes to %zu possible matches, %zu verified and %zu found", method != NULL ? method : "none", skipped, candidates, verified, matches);
+  // the possible matches that were not found to match are false positives of the search method
+  if (candidates > 0 && candidates >= matches)
+    fprintf(output, " (%.1f%% false positives)", 100.0 * static_cast<double>(candidates - matches) / static_cast<double>(candidates));
+  fprintf(output, NEWLINESTR);
+}
+#endif
+
 reflex::timer_type       Stats::timer;
 std::atomic_size_t       Stats::files;
 std::atomic_size_t       Stats::dirs;
@@ -210,8 +336,23 @@ std::atomic_size_t       Stats::indexed;
 std::atomic_size_t       Stats::skipped;
 std::atomic_size_t       Stats::changed;
 std::atomic_size_t       Stats::added;
+std::atomic_size_t       Stats::hits;
+std::atomic_size_t       Stats::misses;
+std::atomic_size_t       Stats::invalidated;
 std::atomic_size_t       Stats::fileno;
 std::atomic_size_t       Stats::partno;
 std::atomic_size_t       Stats::matchno;
 std::atomic_size_t       Stats::lineno;
+std::atomic_size_t       Stats::bytes;
+std::atomic_size_t       Stats::cached;
 std::vector<std::string> Stats::ignore;
+std::atomic<uint64_t>    Stats::phase_time[PHASES];
+std::atomic_size_t       Stats::phase_amount[PHASES];
+bool                     Stats::timing = false;
+#if defined(WITH_MATCHER_STATS)
+std::atomic<const char*> Stats::advance_method;
+std::atomic_size_t       Stats::advance_skipped;
+std::atomic_size_t       Stats::advance_candidates;
+std::atomic_size_t       Stats::advance_verified;
+std::atomic_size_t       Stats::advance_matches;
+#endif
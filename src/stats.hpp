@@ -47,13 +47,83 @@ Stats::found_any_file()
 #define STATS_HPP
 
 #include "ugrep.hpp"
+#include "trace.hpp"
 #include <reflex/timer.h>
+#if defined(WITH_MATCHER_STATS)
+# include <reflex/matcher.h>
+#endif
+#include <chrono>
 
 // static class to collect global statistics
 class Stats {
 
  public:
 
+  // --stats=phases, --stats=json and --trace=FILE: the phases of a search timed per thread
+  enum Phase { NONE, TRAVERSE, SELECT, READ, DECOMPRESS, MATCH, CNF, OUTPUT, WAIT, PHASES };
+
+  // time the current thread spends in a phase until the timer goes out of scope, excluding the time spent in nested phases
+  class Timer {
+
+   public:
+
+    Timer(Phase phase)
+      :
+        prev_(enter(phase))
+    { }
+
+    ~Timer()
+    {
+      enter(prev_);
+    }
+
+   protected:
+
+    Phase prev_; // the phase to resume
+
+  };
+
+  // switch the current thread to a phase and return the phase it was in, the time and amounts are added to the global totals when the thread leaves all phases
+  static Phase enter(Phase phase)
+  {
+    if (!timing)
+      return NONE;
+
+    Clock& clock = thread_clock();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    Phase prev = clock.phase;
+
+    if (prev != NONE)
+    {
+      clock.time[prev] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - clock.since).count();
+
+      // --trace=FILE: record the time slice spent in the phase
+      Trace::complete(phase_name(prev), clock.since, now);
+    }
+
+    clock.phase = phase;
+    clock.since = now;
+
+    if (phase == NONE)
+      clock.flush();
+
+    return prev;
+  }
+
+  // score the number of bytes processed or the number of items in a phase
+  static void score_phase(Phase phase, size_t amount)
+  {
+    if (!timing)
+      return;
+
+    Clock& clock = thread_clock();
+
+    clock.amount[phase] += amount;
+
+    if (clock.phase == NONE)
+      clock.flush();
+  }
+
   // reset stats
   static void reset()
   {
@@ -64,11 +134,28 @@ class Stats {
     skipped = 0;
     changed = 0;
     added = 0;
+    hits = 0;
+    misses = 0;
+    invalidated = 0;
     fileno = 0;
     partno = 0;
     lineno = 0;
     matchno = 0;
+    bytes = 0;
+    cached = 0;
+    for (int i = 0; i < PHASES; ++i)
+    {
+      phase_time[i] = 0;
+      phase_amount[i] = 0;
+    }
     ignore.clear();
+#if defined(WITH_MATCHER_STATS)
+    advance_method = NULL;
+    advance_skipped = 0;
+    advance_candidates = 0;
+    advance_verified = 0;
+    advance_matches = 0;
+#endif
   }
 
   // score a file searched
@@ -83,6 +170,12 @@ class Stats {
     ++dirs;
   }
 
+  // score a number of directories searched
+  static void score_dirs(size_t amount)
+  {
+    dirs += amount;
+  }
+
   // score an indexed file
   static void score_indexed()
   {
@@ -107,6 +200,24 @@ class Stats {
     ++added;
   }
 
+  // --cache: score a file that did not match before and was skipped from search
+  static void score_hit()
+  {
+    ++hits;
+  }
+
+  // --cache: score a file that was not cached and searched
+  static void score_miss()
+  {
+    ++misses;
+  }
+
+  // --cache: score a cached file that was changed and searched
+  static void score_invalidated()
+  {
+    ++invalidated;
+  }
+
   // score matches
   static void score_matches(size_t matches, size_t lines)
   {
@@ -114,6 +225,13 @@ class Stats {
     lineno += lines;
   }
 
+  // score bytes read from a file and the size of the pages of the file left in the page cache that were not cached before
+  static void score_read(size_t read, size_t resident)
+  {
+    bytes += read;
+    cached += resident;
+  }
+
   // number of files searched
   static size_t searched_files()
   {
@@ -150,12 +268,42 @@ class Stats {
     return added;
   }
 
+  // --cache: number of files that did not match before and were skipped from search
+  static size_t cached_hits()
+  {
+    return hits;
+  }
+
+  // --cache: number of files that were not cached and searched
+  static size_t cached_misses()
+  {
+    return misses;
+  }
+
+  // --cache: number of cached files that were changed and searched
+  static size_t cached_invalidated()
+  {
+    return invalidated;
+  }
+
   // number of lines searched
   static size_t searched_lines()
   {
     return lineno;
   }
 
+  // number of bytes read from files searched, tracked with --stats for regular files
+  static size_t searched_bytes()
+  {
+    return bytes;
+  }
+
+  // number of bytes of pages left in the page cache by the search, tracked with --stats for regular files
+  static size_t cached_bytes()
+  {
+    return cached;
+  }
+
   // atomically update the number of matching files found, excluding files in archives returns true if max file matches (+ number of threads-1 when sorting) is not reached yet
   static bool found_file()
   {
@@ -202,6 +350,27 @@ class Stats {
     return matchno;
   }
 
+#if defined(WITH_MATCHER_STATS)
+  // --stats=vm: add the search method counters of a matcher to the totals and clear the matcher's counters
+  static void score_advance(reflex::AbstractMatcher *matcher)
+  {
+    reflex::Matcher *m = dynamic_cast<reflex::Matcher*>(matcher);
+    if (m == NULL)
+      return;
+
+    const reflex::Matcher::Counters& counters = m->counters();
+    advance_method = m->advance_method();
+    advance_skipped += counters.skipped;
+    advance_candidates += counters.candidates;
+    advance_verified += counters.verified;
+    advance_matches += counters.matches;
+    m->clear_counters();
+  }
+
+  // --stats=vm: report the search method counters
+  static void report_advance(FILE *output);
+#endif
+
   // a .gitignore or similar file was encountered
   static void ignore_file(const std::string& filename)
   {
@@ -211,8 +380,62 @@ class Stats {
   // report the statistics
   static void report(FILE *output);
 
+  // --stats=phases: report the time spent and the throughput per phase
+  static void report_phases(FILE *output);
+
+  // --stats=json: report the statistics and the phases in JSON
+  static void report_json(FILE *output);
+
+  static bool timing; // --stats=phases, --stats=json and --trace=FILE: time the phases
+
  protected:
 
+  // per-thread phase timing state, added to the global totals with relaxed atomics
+  struct Clock {
+
+    Clock()
+      :
+        phase(NONE),
+        since(),
+        time(),
+        amount()
+    { }
+
+    // add the time and amounts to the global totals
+    void flush()
+    {
+      for (int i = 0; i < PHASES; ++i)
+      {
+        if (time[i] > 0)
+        {
+          phase_time[i].fetch_add(time[i], std::memory_order_relaxed);
+          time[i] = 0;
+        }
+        if (amount[i] > 0)
+        {
+          phase_amount[i].fetch_add(amount[i], std::memory_order_relaxed);
+          amount[i] = 0;
+        }
+      }
+    }
+
+    Phase                                 phase;          // the phase the thread is in
+    std::chrono::steady_clock::time_point since;          // the time the thread entered the phase
+    uint64_t                              time[PHASES];   // nanoseconds spent per phase
+    size_t                                amount[PHASES]; // bytes or items processed per phase
+
+  };
+
+  // the phase timing state of the current thread
+  static Clock& thread_clock()
+  {
+    static thread_local Clock clock;
+    return clock;
+  }
+
+  // the name of a phase
+  static const char *phase_name(int phase);
+
   static reflex::timer_type       timer;   // elapsed wall-clock time in milli seconds (ms)
   static std::atomic_size_t       files;   // number of files searched, excluding files in archives
   static std::atomic_size_t       dirs;    // number of directories searched
@@ -220,11 +443,25 @@ class Stats {
   static std::atomic_size_t       skipped; // number of files found to be indexed that were skipped as not matching
   static std::atomic_size_t       changed; // number of files found to be indexed but changed (stale index file)
   static std::atomic_size_t       added;   // number of files found to be added (stale index file)
+  static std::atomic_size_t       hits;        // --cache: number of files that did not match before and were skipped
+  static std::atomic_size_t       misses;      // --cache: number of files that were not cached and searched
+  static std::atomic_size_t       invalidated; // --cache: number of cached files that were changed and searched
   static std::atomic_size_t       fileno;  // number of matching files, excluding files in archives, atomic for GrepWorker::search() update
   static std::atomic_size_t       partno;  // number of matching files, including files in archives, atomic for GrepWorker::search() update
   static std::atomic_size_t       lineno;  // number of lines searched cummulatively
   static std::atomic_size_t       matchno; // number of matches found cummulatively
+  static std::atomic_size_t       bytes;   // number of bytes read from regular files
+  static std::atomic_size_t       cached;  // number of bytes of pages left in the page cache that were not cached before
   static std::vector<std::string> ignore;  // the .gitignore files encountered in the recursive search with --ignore-files
+  static std::atomic<uint64_t>    phase_time[PHASES];   // nanoseconds spent per phase by all threads
+  static std::atomic_size_t       phase_amount[PHASES]; // bytes or items processed per phase by all threads
+#if defined(WITH_MATCHER_STATS)
+  static std::atomic<const char*> advance_method;     // the search method of the matcher to advance to a possible match
+  static std::atomic_size_t       advance_skipped;    // number of bytes skipped by the search method
+  static std::atomic_size_t       advance_candidates; // number of possible match positions found by the search method
+  static std::atomic_size_t       advance_verified;   // number of possible matches verified by the DFA or by a string comparison
+  static std::atomic_size_t       advance_matches;    // number of matches found by the matcher
+#endif
 
 };
 
@@ -0,0 +1,140 @@
+/******************************************************************************\
+* Copyright (c) 2019, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      trace.cpp
+@brief     --trace=FILE timeline of per-thread events in Chrome trace event JSON
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2019-2025, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#include "trace.hpp"
+
+// output a JSON string
+static void json_string(FILE *file, const char *s, size_t n)
+{
+  putc('"', file);
+  for (const char *e = s + n; s < e; ++s)
+  {
+    unsigned char c = static_cast<unsigned char>(*s);
+    if (c == '"' || c == '\\')
+    {
+      putc('\\', file);
+      putc(c, file);
+    }
+    else if (c < 0x20)
+    {
+      fprintf(file, "\\u%04x", c);
+    }
+    else
+    {
+      putc(c, file);
+    }
+  }
+  putc('"', file);
+}
+
+// start tracing to the given file opened for writing
+void Trace::open(FILE *trace_file)
+{
+  file = trace_file;
+  epoch = Clock::now();
+  enabled.store(true);
+
+  thread_name("main");
+}
+
+// write the events of all threads to the trace file and stop tracing, the other threads must have stopped
+void Trace::close()
+{
+  if (!enabled.exchange(false))
+    return;
+
+  std::unique_lock<std::mutex> lock(mutex);
+
+  size_t dropped = 0;
+  const char *sep = "\n";
+
+  fprintf(file, "{\"traceEvents\":[");
+
+  for (auto buffer : buffers)
+  {
+    if (!buffer->name.empty())
+    {
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":", sep, buffer->tid);
+      json_string(file, buffer->name.c_str(), buffer->name.size());
+      fprintf(file, "}}");
+      sep = ",\n";
+    }
+
+    // the oldest event is the next event to overwrite when the ring buffer wrapped around
+    size_t size = buffer->events.size();
+    size_t from = buffer->dropped > 0 ? buffer->next % size : 0;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+      const Event& event = buffer->events[(from + i) % size];
+
+      fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"ugrep\",\"ph\":\"%c\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f", sep, event.name, event.type, buffer->tid, 1e-3 * event.time);
+      if (event.type == 'X')
+        fprintf(file, ",\"dur\":%.3f", 1e-3 * event.dur);
+      else
+        fprintf(file, ",\"s\":\"t\"");
+      if (!event.arg.empty())
+      {
+        fprintf(file, ",\"args\":{\"pathname\":");
+        json_string(file, event.arg.c_str(), event.arg.size());
+        fprintf(file, "}");
+      }
+      fprintf(file, "}");
+      sep = ",\n";
+    }
+
+    dropped += buffer->dropped;
+
+    delete buffer;
+  }
+
+  buffers.clear();
+
+  fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":%zu}}\n", dropped);
+
+  if (file != stdout)
+    fclose(file);
+  else
+    fflush(file);
+
+  file = NULL;
+}
+
+std::atomic_bool            Trace::enabled(false);
+FILE                       *Trace::file = NULL;
+Trace::Clock::time_point    Trace::epoch;
+std::mutex                  Trace::mutex;
+std::vector<Trace::Buffer*> Trace::buffers;
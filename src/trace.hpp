@@ -0,0 +1,210 @@
+/******************************************************************************\
+* Copyright (c) 2019, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      trace.hpp
+@brief     --trace=FILE timeline of per-thread events in Chrome trace event JSON
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2019-2025, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+*/
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// --trace=FILE: the maximum number of events buffered per thread, the oldest events are dropped when the buffer wraps around
+#ifndef TRACE_BUFFER_SIZE
+# define TRACE_BUFFER_SIZE 262144
+#endif
+
+// static class to record per-thread events in thread-local ring buffers, written to the trace file when tracing stops
+class Trace {
+
+ public:
+
+  typedef std::chrono::steady_clock Clock;
+
+  // a span of time of the current thread until the span goes out of scope
+  class Span {
+
+   public:
+
+    Span(const char *name, const char *arg = NULL)
+      :
+        name_(name),
+        arg_(arg),
+        start_(is_enabled() ? Clock::now() : Clock::time_point())
+    { }
+
+    ~Span()
+    {
+      if (is_enabled())
+        complete(name_, start_, Clock::now(), arg_);
+    }
+
+   protected:
+
+    const char        *name_;  // the static name of the span
+    const char        *arg_;   // pathname argument or NULL
+    Clock::time_point  start_; // the time the span started
+
+  };
+
+  // start tracing to the given file opened for writing, tracing cannot be restarted after close()
+  static void open(FILE *file);
+
+  // write the events of all threads to the trace file, stop tracing and release the buffers, the other threads must have stopped
+  static void close();
+
+  // true if events are recorded, a relaxed load because the threads only need to see tracing enabled eventually
+  static bool is_enabled()
+  {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  // name the current thread in the trace, numbered when num > 0
+  static void thread_name(const char *name, size_t num = 0)
+  {
+    if (!is_enabled())
+      return;
+
+    Buffer& buffer = thread_buffer();
+    buffer.name.assign(name);
+    if (num > 0)
+      buffer.name.append(" ").append(std::to_string(num));
+  }
+
+  // record a span of time of the current thread from start to end
+  static void complete(const char *name, Clock::time_point start, Clock::time_point end, const char *arg = NULL)
+  {
+    if (!is_enabled())
+      return;
+
+    thread_buffer().add(name, 'X', nanoseconds(start), std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), arg);
+  }
+
+  // record an instant event of the current thread
+  static void instant(const char *name, const char *arg = NULL)
+  {
+    if (!is_enabled())
+      return;
+
+    thread_buffer().add(name, 'i', nanoseconds(Clock::now()), 0, arg);
+  }
+
+  static std::atomic_bool enabled; // --trace=FILE: record events
+
+ protected:
+
+  // a trace event
+  struct Event {
+    const char *name; // the static name of the event
+    char        type; // 'X' complete event or 'i' instant event
+    uint64_t    time; // nanoseconds since tracing started
+    uint64_t    dur;  // duration in nanoseconds of a complete event
+    std::string arg;  // pathname argument or empty
+  };
+
+  // a ring buffer of events of a thread, only accessed by the thread until tracing stops
+  struct Buffer {
+
+    Buffer(size_t tid)
+      :
+        tid(tid),
+        next(0),
+        dropped(0)
+    { }
+
+    // add an event, overwrite the oldest event when the buffer is full
+    void add(const char *name, char type, uint64_t time, uint64_t dur, const char *arg)
+    {
+      if (events.size() < TRACE_BUFFER_SIZE)
+      {
+        events.emplace_back();
+      }
+      else
+      {
+        next %= TRACE_BUFFER_SIZE;
+        ++dropped;
+      }
+
+      Event& event = events[next++];
+      event.name = name;
+      event.type = type;
+      event.time = time;
+      event.dur = dur;
+      if (arg != NULL)
+        event.arg.assign(arg);
+      else
+        event.arg.clear();
+    }
+
+    size_t             tid;     // the thread id in the trace
+    std::string        name;    // the thread name in the trace
+    std::vector<Event> events;  // the events buffered
+    size_t             next;    // the next event to write in the ring buffer
+    size_t             dropped; // number of events dropped
+  };
+
+  // nanoseconds since tracing started
+  static uint64_t nanoseconds(Clock::time_point time)
+  {
+    return time > epoch ? std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch).count() : 0;
+  }
+
+  // the buffer of the current thread, registered once per thread
+  static Buffer& thread_buffer()
+  {
+    static thread_local Buffer *buffer = NULL;
+
+    if (buffer == NULL)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      buffers.push_back(new Buffer(buffers.size() + 1));
+      buffer = buffers.back();
+    }
+
+    return *buffer;
+  }
+
+  static FILE                 *file;    // the trace file
+  static Clock::time_point     epoch;   // the time tracing started
+  static std::mutex            mutex;   // protects buffers when threads register their buffer
+  static std::vector<Buffer*>  buffers; // the buffers of all threads that recorded events
+
+};
+
+#endif
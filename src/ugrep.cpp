@@ -75,11 +75,13 @@ After this, you may want to test ugrep and install it (optional):
 */
 
 #include "ugrep.hpp"
-#include "glob.hpp"
+#include "globs.hpp"
 #include "mmap.hpp"
+#include "directory.hpp"
 #include "output.hpp"
 #include "query.hpp"
 #include "stats.hpp"
+#include "cache.hpp"
 #include <reflex/matcher.h>
 #include <reflex/linematcher.h>
 #include <reflex/fuzzymatcher.h>
@@ -141,6 +143,8 @@ After this, you may want to test ugrep and install it (optional):
 
 #include <signal.h>
 #include <dirent.h>
+#include <sys/wait.h>
+#include <poll.h>
 
 #endif
 
@@ -179,6 +183,11 @@ After this, you may want to test ugrep and install it (optional):
 # define DEFAULT_MAX_JOB_QUEUE_SIZE 8192
 #endif
 
+// --read-order=size: the maximum number of files held back to submit the largest files first
+#ifndef MAX_JOB_WINDOW_SIZE
+# define MAX_JOB_WINDOW_SIZE 4096
+#endif
+
 // a hard limit on the recursive search depth
 #ifndef MAX_DEPTH
 # define MAX_DEPTH 100
@@ -314,6 +323,7 @@ bool flag_csv                      = false;
 bool flag_decompress               = false;
 bool flag_dereference              = false;
 bool flag_dereference_files        = false;
+bool flag_drop_cache               = false;
 bool flag_files                    = false;
 bool flag_files_with_matches       = false;
 bool flag_files_without_match      = false;
@@ -345,6 +355,8 @@ bool flag_only_matching            = false;
 bool flag_perl_regexp              = false;
 bool flag_query                    = false;
 bool flag_quiet                    = false;
+bool flag_records                  = false;
+bool flag_records_spans            = false;
 bool flag_sort_rev                 = false;
 bool flag_split                    = false;
 bool flag_stdin                    = false;
@@ -371,6 +383,7 @@ Flag flag_text;
 Flag flag_tree;
 Flag flag_ungroup;
 Sort flag_sort_key                 = Sort::NA;
+Order flag_read_order_key          = Order::NA;
 Action flag_devices_action         = Action::UNSP;
 Action flag_directories_action     = Action::UNSP;
 size_t flag_after_context          = 0;
@@ -403,6 +416,7 @@ size_t flag_tabs                   = DEFAULT_TABS;
 size_t flag_width                  = 0;
 size_t flag_zmax                   = 1;
 const char *flag_binary_files      = "binary";
+const char *flag_cache             = NULL;
 const char *flag_color             = DEFAULT_COLOR;
 const char *flag_color_query       = NULL;
 const char *flag_colors            = NULL;
@@ -422,14 +436,17 @@ const char *flag_index             = NULL;
 const char *flag_label             = Static::LABEL_STANDARD_INPUT;
 const char *flag_pager             = NULL;
 const char *flag_pretty            = DEFAULT_PRETTY;
+const char *flag_read_order        = NULL;
 const char *flag_replace           = NULL;
 const char *flag_save_config       = NULL;
 const char *flag_separator         = NULL;
 const char *flag_separator_dash    = "-";
 const char *flag_separator_bar     = "|";
 const char *flag_sort              = NULL;
+size_t flag_sort_buffer            = DEFAULT_SORT_BUFFER_SIZE;
 const char *flag_stats             = NULL;
 const char *flag_tag               = NULL;
+const char *flag_trace             = NULL;
 const char *flag_view              = "";
 std::string              flag_filter;
 std::string              flag_hyperlink_prefix;
@@ -458,6 +475,24 @@ std::vector<std::string> flag_all_include;
 std::vector<std::string> flag_all_include_dir;
 std::vector<std::string> flag_all_exclude;
 std::vector<std::string> flag_all_exclude_dir;
+
+// the --include, --exclude and --exclude-dir globs and the globs imported from ignore files, matched by Grep::select()
+static Globs all_include_globs(flag_all_include, flag_include_iglob_size);
+static Globs all_exclude_globs(flag_all_exclude, flag_exclude_iglob_size);
+static Globs all_exclude_dir_globs(flag_all_exclude_dir, flag_exclude_iglob_dir_size);
+
+// --ignore-files: the globs imported from an ignore file and their DFAs, reused by the next searches while the ignore file is unchanged
+struct Ignored {
+  uint64_t                    device;    // device of the ignore file
+  uint64_t                    inode;     // inode of the ignore file
+  uint64_t                    mtime;     // modification time of the ignore file
+  uint64_t                    size;      // size of the ignore file
+  std::vector<std::string>    files;     // globs imported to flag_all_exclude
+  std::vector<std::string>    dirs;      // globs imported to flag_all_exclude_dir
+  std::shared_ptr<Globs::Set> files_set; // the DFAs of the files globs
+  std::shared_ptr<Globs::Set> dirs_set;  // the DFAs of the dirs globs
+};
+static std::map<std::string,Ignored> ignored_files;
 reflex::Input::file_encoding_type flag_encoding_type = reflex::Input::file_encoding::plain;
 
 // store string arguments and the UTF-8 arguments decoded from wargv[] in strings to re-populate argv[] with pointers
@@ -487,6 +522,7 @@ void strtopos2(const char *string, size_t& pos1, size_t& pos2, const char *messa
 size_t strtosize(const char *string, const char *message);
 size_t strtofuzzy(const char *string, const char *message);
 void import_globs(FILE *file, std::vector<std::string>& files, std::vector<std::string>& dirs, bool gitignore = false, const char *pathname = NULL);
+Ignored& import_ignore_file(FILE *file, const std::string& filename, const char *pathname);
 void usage(const char *message, const char *arg = NULL, const char *valid = NULL);
 void help(std::ostream& out);
 void help(const char *what = NULL);
@@ -823,7 +859,7 @@ struct Zthread {
     }
 
     // open pipe between Grep (or previous decompression) thread and this (new) decompression thread
-    if (pipe(pipe_fd) == 0 && (pipe_in = fdopen(pipe_fd[0], "rb")) != NULL)
+    if (pipe_cloexec(pipe_fd) == 0 && (pipe_in = fdopen(pipe_fd[0], "rb")) != NULL)
     {
       // recursively add decompression stages to decompress multi-compressed files
       if (ztstage > 1)
@@ -940,7 +976,7 @@ struct Zthread {
         FILE *pipe_in = NULL;
 
         // open pipe between worker and decompression thread, then start decompression thread
-        if (pipe(pipe_fd) == 0 && (pipe_in = fdopen(pipe_fd[0], "rb")) != NULL)
+        if (pipe_cloexec(pipe_fd) == 0 && (pipe_in = fdopen(pipe_fd[0], "rb")) != NULL)
         {
           if (is_chained)
           {
@@ -1081,9 +1117,26 @@ struct Zthread {
     lock.unlock();
   }
 
+  // decompress a block of data into buf[0..maxlen-1], return number of bytes decompressed, zero on EOF or negative on error
+  std::streamsize decompress_block(unsigned char *buf, size_t maxlen)
+  {
+    // --stats=phases: time decompression
+    Stats::Timer timer(Stats::DECOMPRESS);
+
+    std::streamsize len = zstream->decompress(buf, maxlen);
+
+    if (len > 0)
+      Stats::score_phase(Stats::DECOMPRESS, static_cast<size_t>(len));
+
+    return len;
+  }
+
   // decompression thread execution
   void decompress()
   {
+    // --trace=FILE: name this thread in the timeline
+    Trace::thread_name("decompress");
+
     while (!quit)
     {
       // use the zstreambuf internal buffer to hold decompressed data
@@ -1130,7 +1183,7 @@ struct Zthread {
         bool is_selected = false;
 
         // decompress a block of data into the buffer
-        std::streamsize len = zstream->decompress(buf, maxlen);
+        std::streamsize len = decompress_block(buf, maxlen);
 
         if (len >= 0)
         {
@@ -1189,7 +1242,7 @@ struct Zthread {
               }
 
               // decompress the next block of data into the buffer
-              len = zstream->decompress(buf, maxlen);
+              len = decompress_block(buf, maxlen);
             }
           }
         }
@@ -1425,7 +1478,7 @@ struct Zthread {
             }
 
             // decompress the next block of data into the buffer
-            len = zstream->decompress(buf, maxlen);
+            len = decompress_block(buf, maxlen);
           }
 
           // error?
@@ -1435,7 +1488,7 @@ struct Zthread {
           // fill the rest of the buffer with decompressed data
           while (len < BLOCKSIZE || static_cast<size_t>(len) < maxlen)
           {
-            std::streamsize len_in = zstream->decompress(buf + len, maxlen - static_cast<size_t>(len));
+            std::streamsize len_in = decompress_block(buf + len, maxlen - static_cast<size_t>(len));
 
             // error or EOF?
             if (len_in <= 0)
@@ -1640,7 +1693,7 @@ struct Zthread {
             }
 
             // decompress the next block of data into the buffer
-            len = zstream->decompress(buf, maxlen);
+            len = decompress_block(buf, maxlen);
           }
 
           // error?
@@ -1658,7 +1711,7 @@ struct Zthread {
           // fill the rest of the buffer with decompressed data
           if (static_cast<size_t>(len) < maxlen)
           {
-            std::streamsize len_in = zstream->decompress(buf + len, maxlen - static_cast<size_t>(len));
+            std::streamsize len_in = decompress_block(buf + len, maxlen - static_cast<size_t>(len));
 
             // error?
             if (len_in < 0)
@@ -1740,7 +1793,7 @@ struct Zthread {
             }
 
             // decompress the next block of data into the buffer
-            len = zstream->decompress(buf, maxlen);
+            len = decompress_block(buf, maxlen);
           }
 
           // error?
@@ -1750,7 +1803,7 @@ struct Zthread {
           if (static_cast<size_t>(len) < maxlen)
           {
             // fill the rest of the buffer with decompressed data
-            std::streamsize len_in = zstream->decompress(buf + len, maxlen - static_cast<size_t>(len));
+            std::streamsize len_in = decompress_block(buf + len, maxlen - static_cast<size_t>(len));
 
             // error?
             if (len_in < 0)
@@ -1962,6 +2015,10 @@ struct Grep {
     // get sortable info from stat buf
     static uint64_t sort_info(const struct stat& buf)
     {
+      // --read-order=size without --sort: the file size to search the largest files first
+      if (flag_sort_key == Sort::NA && flag_read_order_key == Order::SIZE)
+        return static_cast<uint64_t>(buf.st_size);
+
 #if defined(HAVE_STAT_ST_ATIM) && defined(HAVE_STAT_ST_MTIM) && defined(HAVE_STAT_ST_CTIM)
       // tv_sec may be 64 bit, but value is small enough to multiply by 1000000 to fit in 64 bits
       return static_cast<uint64_t>(flag_sort_key == Sort::SIZE ? buf.st_size : flag_sort_key == Sort::USED ? static_cast<uint64_t>(buf.st_atim.tv_sec) * 1000000 + buf.st_atim.tv_nsec / 1000 : flag_sort_key == Sort::CHANGED ? static_cast<uint64_t>(buf.st_mtim.tv_sec) * 1000000 + buf.st_mtim.tv_nsec / 1000 : flag_sort_key == Sort::CREATED ? static_cast<uint64_t>(buf.st_ctim.tv_sec) * 1000000 + buf.st_ctim.tv_nsec / 1000 : 0);
@@ -2291,6 +2348,27 @@ struct Grep {
 
   };
 
+  // extend the reflex::Input::Handler to drop pages behind the read position from the page cache with --drop-cache, then invoke the next handler
+  struct CacheHandler : public reflex::Input::Handler {
+
+    CacheHandler(Grep& grep)
+      :
+        grep(grep),
+        next(NULL)
+    { }
+
+    Grep&                   grep;
+    reflex::Input::Handler *next; // the next handler to invoke or NULL
+
+    size_t operator()(FILE *file, char *buf, size_t len)
+    {
+      grep.cache.read(len);
+
+      return next != NULL ? (*next)(file, buf, len) : len;
+    }
+
+  };
+
 #ifndef OS_WIN
 
   // extend the reflex::Input::Handler to handle non-blocking input from a character device (TTY) or from a pipe
@@ -2326,6 +2404,212 @@ struct Grep {
 
   };
 
+#endif
+
+#ifndef OS_WIN_OR_MINGW
+
+  // --filter: a long-lived coprocess of a |command that filters the files sent to it, each request and response is prefixed with its 64-bit little-endian length
+  struct Coprocess {
+
+    Coprocess()
+      :
+        pid(-1),
+        to(-1),
+        from(-1)
+    { }
+
+    Coprocess(const Coprocess&) = delete;
+
+    ~Coprocess()
+    {
+      stop();
+    }
+
+    // start the coprocess of the command, return false on failure
+    bool start(const std::string& command)
+    {
+      int in[2];
+      int out[2];
+
+      if (pipe_cloexec(in) != 0)
+        return false;
+
+      if (pipe_cloexec(out) != 0)
+      {
+        close(in[0]);
+        close(in[1]);
+        return false;
+      }
+
+      if ((pid = fork()) == 0)
+      {
+        // child process reads requests from stdin and writes responses to stdout
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+
+        // execute the command with its arguments on a copy of the command, where % is replaced by -
+        std::string args(command);
+        filter_exec(&args[0], "-");
+      }
+
+      close(in[0]);
+      close(out[1]);
+
+      if (pid < 0)
+      {
+        close(in[1]);
+        close(out[0]);
+        pid = -1;
+        return false;
+      }
+
+      to = in[1];
+      from = out[0];
+
+      // non-blocking pipe ends to receive the response while the request is sent
+      fcntl(to, F_SETFL, fcntl(to, F_GETFL) | O_NONBLOCK);
+      fcntl(from, F_SETFL, fcntl(from, F_GETFL) | O_NONBLOCK);
+
+      return true;
+    }
+
+    // send the data to the coprocess and replace it with the response, which is received while the request is sent to a coprocess that streams its response, return false on failure
+    bool filter(std::string& data)
+    {
+      unsigned char request[8];
+      unsigned char reply[8];
+      uint64_t size = data.size();
+      uint64_t length = 0;
+      size_t total = sizeof(request) + data.size();
+      size_t sent = 0;
+      size_t received = 0;
+
+      for (int i = 0; i < 8; ++i)
+        request[i] = static_cast<unsigned char>(size >> (8 * i));
+
+      response.clear();
+
+      // until the request is sent and the response header and the response data of the given length are received
+      while (sent < total || received < sizeof(reply) + length)
+      {
+        struct pollfd fds[2];
+        nfds_t nfds = 0;
+
+        if (sent < total)
+        {
+          fds[nfds].fd = to;
+          fds[nfds].events = POLLOUT;
+          fds[nfds].revents = 0;
+          ++nfds;
+        }
+
+        if (received < sizeof(reply) + length)
+        {
+          fds[nfds].fd = from;
+          fds[nfds].events = POLLIN;
+          fds[nfds].revents = 0;
+          ++nfds;
+        }
+
+        if (poll(fds, nfds, -1) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return false;
+        }
+
+        for (nfds_t i = 0; i < nfds; ++i)
+        {
+          if (fds[i].revents == 0)
+            continue;
+
+          if (fds[i].fd == to)
+          {
+            // send the next part of the request header or data
+            ssize_t nwritten;
+            if (sent < sizeof(request))
+              nwritten = write(to, request + sent, sizeof(request) - sent);
+            else
+              nwritten = write(to, data.data() + sent - sizeof(request), total - sent);
+
+            if (nwritten < 0)
+            {
+              if (errno == EINTR || errno == EAGAIN)
+                continue;
+              return false;
+            }
+
+            sent += nwritten;
+          }
+          else
+          {
+            // receive the next part of the response header or data
+            ssize_t nread;
+            if (received < sizeof(reply))
+              nread = read(from, reply + received, sizeof(reply) - received);
+            else
+              nread = read(from, &response[received - sizeof(reply)], sizeof(reply) + length - received);
+
+            if (nread <= 0)
+            {
+              if (nread < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+              if (nread == 0)
+                errno = 0;
+              return false;
+            }
+
+            received += nread;
+
+            // the response header is received, allocate the response data
+            if (received == sizeof(reply) && length == 0)
+            {
+              for (int j = 7; j >= 0; --j)
+                length = (length << 8) | reply[j];
+
+              try
+              {
+                response.resize(static_cast<size_t>(length));
+              }
+
+              catch (std::exception&)
+              {
+                return false;
+              }
+            }
+          }
+        }
+      }
+
+      data.swap(response);
+
+      return true;
+    }
+
+    // stop the coprocess by closing its pipes and terminating it
+    void stop()
+    {
+      if (pid > 0)
+      {
+        close(to);
+        close(from);
+        kill(pid, SIGTERM);
+        while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
+          continue;
+      }
+
+      pid = -1;
+      to = -1;
+      from = -1;
+    }
+
+    pid_t       pid;      // process id of the coprocess or -1 when not running
+    int         to;       // non-blocking writing end of the pipe to the coprocess stdin
+    int         from;     // non-blocking reading end of the pipe from the coprocess stdout
+    std::string response; // the response received, swapped with the request data
+
+  };
+
 #endif
 
   // extend the reflex::AbstractMatcher::Handler with a grep object reference and references to some of the grep::search locals
@@ -3233,8 +3517,10 @@ struct Grep {
       out(file),
       matcher(matcher),
       matchers(matchers),
+      mmap(cache),
       file_in(NULL),
-      bin_handler(*this)
+      bin_handler(*this),
+      cache_handler(*this)
 #ifndef OS_WIN_OR_MINGW
     , stdin_handler(*this)
 #endif
@@ -3297,6 +3583,20 @@ struct Grep {
   // search a file or archive
   virtual void search(const char *pathname, uint16_t cost);
 
+  // --read-order=size: search a file of the given size, GrepMaster holds files back to submit the largest files first
+  virtual void schedule(std::string& pathname, uint64_t size)
+  {
+    (void)size;
+    search(pathname.c_str(), Entry::UNDEFINED_COST);
+  }
+
+  // --query: add a file to the files selected by the directory traversal, to search them again with the next query
+  static void cache_selected(const char *pathname)
+  {
+    if (Static::selected.caching)
+      Static::selected.files.emplace_back(pathname);
+  }
+
   // search input after lineno to populate a string vector with the matching line and lines after up to max lines
   void find_text_preview(const char *filename, const char *partname, size_t from_lineno, size_t max, size_t& lineno, size_t& num, std::vector<std::string>& text);
 
@@ -3306,6 +3606,10 @@ struct Grep {
   // check CNF AND/OR/NOT conditions are met for the line(s) spanning bol to eol
   bool cnf_matching(const char *bol, const char *eol, bool acquire = false)
   {
+    // --stats=phases: time evaluating CNF AND/OR/NOT matching
+    Stats::Timer timer(Stats::CNF);
+    Stats::score_phase(Stats::CNF, 1);
+
     if (flag_files)
     {
       if (out.holding())
@@ -3459,6 +3763,10 @@ struct Grep {
   // open a file for (binary) reading and assign input, decompress the file when -z, --decompress specified, may throw bad_alloc
   bool open_file(const char *pathname, const char *find = NULL)
   {
+    // --stats=phases: time opening files
+    Stats::Timer timer(Stats::READ);
+    Stats::score_phase(Stats::READ, 1);
+
     if (pathname == Static::LABEL_STANDARD_INPUT)
     {
       if (Static::source == NULL)
@@ -3500,6 +3808,10 @@ struct Grep {
     }
 #endif
 
+    // --drop-cache and --stats: track the pages of a regular file resident in the page cache before reading the file
+    if (file_in != stdin && file_in != Static::source)
+      cache.open(fileno(file_in));
+
 #ifdef HAVE_LIBZ
     if (flag_decompress)
     {
@@ -3509,6 +3821,7 @@ struct Grep {
       FILE *pipe_in = zthread.start(flag_zmax, pathname, file_in, find);
       if (pipe_in == NULL)
       {
+        cache.close();
         fclose(file_in);
         file_in = NULL;
 
@@ -3665,13 +3978,20 @@ struct Grep {
         // skip over the ':'
         ++command;
 
+        while (isspace(static_cast<unsigned char>(*command)))
+          ++command;
+
+        // a command that starts with a | is a coprocess that filters files sent to it
+        if (*command == '|')
+          return coprocess(in, pathname, command + 1);
+
         int fd[2];
 
 #ifdef OS_WIN_OR_MINGW
         // Windows CreateProcess requires an "inherited" pipe handle specific to Windows
         bool ok = (pipe_inherit(fd) == 0);
 #else
-        bool ok = (pipe(fd) == 0);
+        bool ok = (pipe_cloexec(fd) == 0);
 #endif
 
         if (ok)
@@ -3762,112 +4082,208 @@ struct Grep {
             dup2(fd[1], STDOUT_FILENO);
             close(fd[1]);
 
-            // -q or -q: suppress error messages sent to stderr by the filter command by redirecting to /dev/null
-            if (flag_quiet || flag_no_messages)
-            {
-              int dev_null = open("/dev/null", O_WRONLY);
-              if (dev_null >= 0)
-              {
-                dup2(dev_null, STDERR_FILENO);
-                close(dev_null);
-              }
-            }
+            // execute the command with its arguments
+            filter_exec(const_cast<char*>(command), in == stdin ? "-" : pathname);
+          }
 
-            // populate argv[] with the command and its arguments, destroying flag_filter in the child process
-            std::vector<const char*> args;
+#endif
 
-            char *arg = const_cast<char*>(command);
+          // close the writing end of the pipe
+          close(fd[1]);
 
-            while (*arg != '\0' && *arg != ',')
-            {
-              while (isspace(static_cast<unsigned char>(*arg)))
-                ++arg;
+          // close the file and use the reading end of the pipe
+          if (in != NULL && in != stdin)
+            fclose(in);
+          in = fdopen(fd[0], "r");
+        }
+        else
+        {
+          if (in != stdin)
+            fclose(in);
+          in = NULL;
 
-              char *s = arg;
+          warning("--filter: cannot create pipe", flag_filter.c_str());
 
-              if (*arg == '"')
-              {
-                // "quoted argument" separated by space
-                ++s;
+          return false;
+        }
+      }
+    }
 
-                while (*s != '\0' &&
-                    (*s != '"' ||
-                     (s[1] != '\0' && s[1] != ',' && !isspace(static_cast<unsigned char>(s[1])))))
-                  ++s;
+    return true;
+  }
 
-                if (*s == '"')
-                {
-                  ++arg;
-                  *s++ = '\0';
-                }
-              }
-              else
-              {
-                // space-separated argument
-                while (*s != '\0' && *s != ',' && !isspace(static_cast<unsigned char>(*s)))
-                  ++s;
-              }
+  // --filter: filter the input with the coprocess of the command, started when the command is used first, return false on failure
+  bool coprocess(FILE*& in, const char *pathname, const char *command)
+  {
+    // the coprocess of the command up to the next unquoted comma
+    const char *end = command;
+    while (*end != '\0' && *end != ',')
+    {
+      if (*end++ == '"')
+      {
+        while (*end != '\0' && *end != '"')
+          ++end;
+        if (*end == '"')
+          ++end;
+      }
+    }
 
-              if (s > arg)
-              {
-                if (s - arg == 1 && *arg == '%')
-                  args.push_back(in == stdin ? "-" : pathname);
-                else
-                  args.push_back(arg);
-              }
+    std::string key(command, end - command);
 
-              if (*s == ',')
-                *s = '\0';
+#ifdef OS_WIN_OR_MINGW
 
-              if (*s == '\0')
-                break;
+    (void)pathname;
 
-              *s = '\0';
+    if (in != stdin)
+      fclose(in);
+    in = NULL;
 
-              arg = s + 1;
-            }
+    errno = 0;
+    warning("--filter: coprocess commands are not supported", key.c_str());
 
-            // silently bail out if there is no command
-            if (args.empty())
-              exit(EXIT_SUCCESS);
+    return false;
 
-            // add sentinel
-            args.push_back(NULL);
+#else
 
-            // get argv[] array data
-            char * const *argv = const_cast<char * const *>(args.data());
+    Coprocess& coprocess = coprocesses[key];
 
-            // execute
-            execvp(argv[0], argv);
+    // read the input to send to the coprocess
+    char buf[16384];
+    size_t len;
+    filtered.clear();
+    while ((len = fread(buf, 1, sizeof(buf), in)) > 0)
+      filtered.append(buf, len);
 
-            error("--filter: cannot exec", argv[0]);
-          }
+    bool ok = !ferror(in);
+
+    if (in != stdin)
+      fclose(in);
+    in = NULL;
+
+    if (!ok)
+    {
+      warning("cannot read", pathname);
+
+      return false;
+    }
+
+    // start the coprocess when not running, then send the input and receive the filtered output
+    if ((coprocess.pid <= 0 && !coprocess.start(key)) || !coprocess.filter(filtered))
+    {
+      warning("--filter: coprocess failed", key.c_str());
+      coprocess.stop();
+
+      return false;
+    }
 
+    // read the filtered output from memory, or from a temporary file when fmemopen() is not available
+#ifdef HAVE_FMEMOPEN
+    in = filtered.empty() ? fopen("/dev/null", "r") : fmemopen(&filtered[0], filtered.size(), "r");
+#else
+    in = tmpfile();
+    if (in != NULL && (fwrite(filtered.data(), 1, filtered.size(), in) < filtered.size() || fseek(in, 0, SEEK_SET) != 0))
+    {
+      fclose(in);
+      in = NULL;
+    }
 #endif
+    if (in == NULL)
+    {
+      warning("--filter: cannot read the output of coprocess", key.c_str());
 
-          // close the writing end of the pipe
-          close(fd[1]);
+      return false;
+    }
 
-          // close the file and use the reading end of the pipe
-          if (in != NULL && in != stdin)
-            fclose(in);
-          in = fdopen(fd[0], "r");
-        }
-        else
-        {
-          if (in != stdin)
-            fclose(in);
-          in = NULL;
+    return true;
 
-          warning("--filter: cannot create pipe", flag_filter.c_str());
+#endif
+  }
 
-          return false;
+#ifndef OS_WIN_OR_MINGW
+  // --filter: execute the command with its arguments in the child process, where % is replaced by pathname, does not return
+  static void filter_exec(char *command, const char *pathname)
+  {
+    // -q or -q: suppress error messages sent to stderr by the filter command by redirecting to /dev/null
+    if (flag_quiet || flag_no_messages)
+    {
+      int dev_null = open("/dev/null", O_WRONLY);
+      if (dev_null >= 0)
+      {
+        dup2(dev_null, STDERR_FILENO);
+        close(dev_null);
+      }
+    }
+
+    // populate argv[] with the command and its arguments, destroying flag_filter in the child process
+    std::vector<const char*> args;
+
+    char *arg = command;
+
+    while (*arg != '\0' && *arg != ',')
+    {
+      while (isspace(static_cast<unsigned char>(*arg)))
+        ++arg;
+
+      char *s = arg;
+
+      if (*arg == '"')
+      {
+        // "quoted argument" separated by space
+        ++s;
+
+        while (*s != '\0' &&
+            (*s != '"' ||
+             (s[1] != '\0' && s[1] != ',' && !isspace(static_cast<unsigned char>(s[1])))))
+          ++s;
+
+        if (*s == '"')
+        {
+          ++arg;
+          *s++ = '\0';
         }
       }
+      else
+      {
+        // space-separated argument
+        while (*s != '\0' && *s != ',' && !isspace(static_cast<unsigned char>(*s)))
+          ++s;
+      }
+
+      if (s > arg)
+      {
+        if (s - arg == 1 && *arg == '%')
+          args.push_back(pathname);
+        else
+          args.push_back(arg);
+      }
+
+      if (*s == ',')
+        *s = '\0';
+
+      if (*s == '\0')
+        break;
+
+      *s = '\0';
+
+      arg = s + 1;
     }
 
-    return true;
+    // silently bail out if there is no command
+    if (args.empty())
+      exit(EXIT_SUCCESS);
+
+    // add sentinel
+    args.push_back(NULL);
+
+    // get argv[] array data
+    char * const *argv = const_cast<char * const *>(args.data());
+
+    // execute
+    execvp(argv[0], argv);
+
+    error("--filter: cannot exec", argv[0]);
   }
+#endif
 
   // close the file and clear input, return true if next file is extracted from an archive to search
   bool close_file(const char *pathname)
@@ -3934,6 +4350,13 @@ struct Grep {
     // close the current input file
     if (file_in != NULL && file_in != stdin && file_in != Static::source)
     {
+      // --drop-cache and --stats: release mmap pages, drop pages that were not cached before and score bytes read
+      if (cache.active())
+      {
+        mmap.release();
+        cache.close();
+      }
+
       fclose(file_in);
       file_in = NULL;
     }
@@ -3946,6 +4369,9 @@ struct Grep {
   // specify input to read for matcher, when input is a regular file then try mmap for zero copy overhead
   bool init_read()
   {
+    // --stats=phases: time mapping files and reading the start of files to check for binary files, the rest is read while matching
+    Stats::Timer timer(Stats::READ);
+
     // initialize Grep search and output variables
     binfile = false;
     lineno = flag_min_line > 0 ? flag_min_line - 1 : 0;
@@ -3957,15 +4383,26 @@ struct Grep {
 
     const char *base;
     size_t size;
+    bool mapped = true;
+    reflex::Input::Handler *handler = NULL;
 
     // attempt to mmap the input file, if mmap is supported and enabled (disabled by default)
     if (mmap.file(input, base, size))
     {
       // matcher reads directly from protected mmap memory (cast is safe: base[0..size] is not modified!)
       matcher->buffer(const_cast<char*>(base), size + 1);
+
+      cache.mapped(size);
+    }
+    else if (mmap.window(input, base, size))
+    {
+      // file is larger than --max-mmap: matcher reads directly from a mmap window that slides over the file
+      matcher->window(&mmap, const_cast<char*>(base), size);
     }
     else
     {
+      mapped = false;
+
       // assign input to the matcher to search
       matcher->input(input);
 
@@ -3981,7 +4418,7 @@ struct Grep {
 #ifndef OS_WIN_OR_MINGW
         // set interactive search handler e.g. for slow stdin input
         if (interactive)
-          matcher->in.set_handler(&stdin_handler);
+          matcher->in.set_handler(handler = &stdin_handler);
 #endif
     }
 
@@ -4001,10 +4438,17 @@ struct Grep {
         binfile = init_is_binary();
 
         // detect binary input dynamically when more input is read after checking the inital input
-        matcher->in.set_handler(&bin_handler);
+        matcher->in.set_handler(handler = &bin_handler);
       }
     }
 
+    // --drop-cache: drop pages behind the read position while reading a regular file, then invoke the handler set
+    if (flag_drop_cache && cache.active() && !mapped && !flag_decompress)
+    {
+      cache_handler.next = handler;
+      matcher->in.set_handler(&cache_handler);
+    }
+
     // --range=[MIN,][MAX]: start searching at line MIN
     for (size_t i = flag_min_line; i > 1; --i)
       if (!matcher->skip('\n'))
@@ -4106,7 +4550,11 @@ struct Grep {
   Static::Matchers              *matchers;      // the CNF of AND/OR/NOT matchers or NULL
   std::vector<bool>              matching;      // bitmap to keep track of globally matching CNF terms
   std::vector<std::vector<bool>> notmatching;   // bitmap to keep track of globally matching OR NOT CNF terms
+  PageCache                      cache;         // page cache tracking of the file searched with --drop-cache and --stats
   MMap                           mmap;          // mmap state
+#ifndef OS_WIN_OR_MINGW
+  Directory                      directory;     // the directory read by recurse() to select its entries
+#endif
   reflex::Input                  input;         // input to the matcher
   FILE                          *file_in;       // the current input file
   bool                           interactive;   // the file being searched is a TTY or pipe
@@ -4118,8 +4566,11 @@ struct Grep {
   size_t                         matches;       // number of matches
   bool                           stop;          // stop searching when --max-files max reached
   BinaryHandler                  bin_handler;   // a handler to detect binary input like GNU grep
+  CacheHandler                   cache_handler; // a handler to drop pages behind the read position with --drop-cache
 #ifndef OS_WIN_OR_MINGW
   StdInHandler                   stdin_handler; // a handler to handle non-blocking input from a TTY or a slow pipe
+  std::map<std::string,Coprocess> coprocesses;  // --filter: the coprocesses of the |commands started by this worker
+  std::string                    filtered;      // --filter: the input sent to a coprocess, then its output read with fmemopen()
 #endif
 #ifdef HAVE_LIBZ
 #ifdef WITH_DECOMPRESSION_THREAD
@@ -4145,6 +4596,10 @@ struct GrepMaster : public Grep {
     // master and workers synchronize their output
     out.sync_on(&sync);
 
+    // --sort: workers hand their output over to the writer thread, except with --max-files that requires workers to take turns to count matching files
+    if (flag_max_files == 0)
+      sync.start_writer(out.file);
+
     // set global handle to be able to call cancel_ugrep()
     Static::set_grep_handle(this);
 
@@ -4159,6 +4614,7 @@ struct GrepMaster : public Grep {
   virtual ~GrepMaster()
   {
     stop_workers();
+    sync.stop_writer();
     Static::clear_grep_handle();
   }
 
@@ -4200,6 +4656,38 @@ struct GrepMaster : public Grep {
     submit(pathname, cost);
   }
 
+  // search the specified files, then submit the files still held back by schedule()
+  void ugrep() override
+  {
+    Grep::ugrep();
+
+    while (!window.empty() && !out.eof && !out.cancelled())
+      submit_largest();
+
+    window.clear();
+  }
+
+  // --read-order=size: hold back files in a window to submit the largest file first when a worker is idle or when the window is full
+  void schedule(std::string& pathname, uint64_t size) override
+  {
+    window.emplace_back(pathname, 0, size);
+    std::push_heap(window.begin(), window.end(), Entry::comp_by_info);
+
+    while (!window.empty() && (window.size() > MAX_JOB_WINDOW_SIZE || idle()))
+      submit_largest();
+  }
+
+  // submit the largest file held back by schedule()
+  void submit_largest()
+  {
+    std::pop_heap(window.begin(), window.end(), Entry::comp_by_info);
+    submit(window.back().pathname.c_str(), Entry::UNDEFINED_COST);
+    window.pop_back();
+  }
+
+  // true if a worker has no jobs to do
+  bool idle();
+
   // start worker threads
   void start_workers();
 
@@ -4215,6 +4703,7 @@ struct GrepMaster : public Grep {
   std::list<GrepWorker>           workers; // workers running threads
   std::list<GrepWorker>::iterator iworker; // the next worker to submit a job to
   Output::Sync                    sync;    // sync output of workers
+  std::vector<Entry>              window;  // --read-order=size: files held back in a max-heap by size
 
 };
 
@@ -4314,6 +4803,9 @@ void GrepMaster::stop_workers()
 // submit a job with a pathname to a worker
 void GrepMaster::submit(const char *pathname, uint16_t cost)
 {
+  // --trace=FILE: mark the submission of the job in the timeline
+  Trace::instant("submit", pathname);
+
   while (true)
   {
     size_t min_todo = iworker->jobs.todo;
@@ -4371,6 +4863,16 @@ void GrepMaster::submit(const char *pathname, uint16_t cost)
     iworker = workers.begin();
 }
 
+// true if a worker has no jobs to do
+bool GrepMaster::idle()
+{
+  for (const auto& worker : workers)
+    if (worker.jobs.todo == 0)
+      return true;
+
+  return false;
+}
+
 #ifndef WITH_LOCK_FREE_JOB_QUEUE
 
 // job stealing on behalf of a worker from a co-worker with at least --min-steal jobs still to do
@@ -4406,6 +4908,9 @@ bool GrepMaster::steal(GrepWorker *worker)
   // steal a job from the co-worker for this worker
   if (coworker->jobs.steal_job(job))
   {
+    // --trace=FILE: mark the stolen job in the timeline of the worker
+    Trace::instant("steal", job.pathname.c_str());
+
     worker->jobs.move_job(job);
 
     return true;
@@ -4423,6 +4928,9 @@ void GrepWorker::execute()
   if (Static::cores >= 3)
     set_this_thread_affinity_and_priority(id);
 
+  // --trace=FILE: name this thread in the timeline
+  Trace::thread_name("worker", id + 1);
+
   Job job;
 
   while (!out.eof && !out.cancelled())
@@ -4434,11 +4942,16 @@ void GrepWorker::execute()
     if (job.none())
       break;
 
+    const char *pathname = job.pathname.empty() ? Static::LABEL_STANDARD_INPUT : job.pathname.c_str();
+
+    // --trace=FILE: the job spans the search and its output
+    Trace::Span span("job", pathname);
+
     // start synchronizing output for this job slot in ORDERED mode (--sort)
     out.begin(job.slot);
 
     // search the file for this job, an empty pathname means stdin
-    search(job.pathname.empty() ? Static::LABEL_STANDARD_INPUT : job.pathname.c_str(), job.cost);
+    search(pathname, job.cost);
 
     // end output in ORDERED mode (--sort) for this job slot
     out.end();
@@ -4476,6 +4989,9 @@ reflex::Pattern Static::filter_magic_pattern; // concurrent access is thread saf
 const char *Static::arg_pattern = NULL;
 std::vector<const char*> Static::arg_files;
 
+// --query: the files selected by the last search
+Static::Selected Static::selected;
+
 // number of cores
 size_t Static::cores;
 
@@ -5375,7 +5891,13 @@ void options(std::list<std::pair<CNF::PATTERN,const char*>>& pattern_args, int a
                 break;
 
               case 'c':
-                if (strcmp(arg, "color") == 0 || strcmp(arg, "colour") == 0)
+                if (strncmp(arg, "cache=", 6) == 0)
+#ifdef OS_WIN_OR_MINGW
+                  usage("option --cache=FILE is not supported");
+#else
+                  flag_cache = getloptarg(argc, argv, arg + 6, i);
+#endif
+                else if (strcmp(arg, "color") == 0 || strcmp(arg, "colour") == 0)
                   flag_color = Static::AUTO;
                 else if (strncmp(arg, "color=", 6) == 0)
                   flag_color = strarg(getloptarg(argc, argv, arg + 6, i));
@@ -5403,10 +5925,10 @@ void options(std::list<std::pair<CNF::PATTERN,const char*>>& pattern_args, int a
                   flag_cpp = true;
                 else if (strcmp(arg, "csv") == 0)
                   flag_csv = true;
-                else if (strcmp(arg, "colors") == 0 || strcmp(arg, "colours") == 0 || strcmp(arg, "context-separator") == 0)
+                else if (strcmp(arg, "cache") == 0 || strcmp(arg, "colors") == 0 || strcmp(arg, "colours") == 0 || strcmp(arg, "context-separator") == 0)
                   usage("missing argument for --", arg);
                 else
-                  usage("invalid option --", arg, "--color, --colors=, --column-number, --config, --confirm, --context=, context-separator=, --count, --cpp or --csv");
+                  usage("invalid option --", arg, "--cache=, --color, --colors=, --column-number, --config, --confirm, --context=, context-separator=, --count, --cpp or --csv");
                 break;
 
               case 'd':
@@ -5434,10 +5956,12 @@ void options(std::list<std::pair<CNF::PATTERN,const char*>>& pattern_args, int a
                   flag_directories = strarg(getloptarg(argc, argv, arg + 12, i));
                 else if (strcmp(arg, "dotall") == 0)
                   flag_dotall = true;
+                else if (strcmp(arg, "drop-cache") == 0)
+                  flag_drop_cache = true;
                 else if (strcmp(arg, "delay") == 0)
                   usage("missing argument for --", arg);
                 else
-                  usage("invalid option --", arg, "--decompress, --delay=, --depth=, --dereference, --dereference-files, --dereference-recursive, --devices=, --directories= or --dotall");
+                  usage("invalid option --", arg, "--decompress, --delay=, --depth=, --dereference, --dereference-files, --dereference-recursive, --devices=, --directories=, --dotall or --drop-cache");
                 break;
 
               case 'e':
@@ -5714,6 +6238,8 @@ void options(std::list<std::pair<CNF::PATTERN,const char*>>& pattern_args, int a
                   flag_dereference_files = false;
                 else if (strcmp(arg, "no-dotall") == 0)
                   flag_dotall = false;
+                else if (strcmp(arg, "no-drop-cache") == 0)
+                  flag_drop_cache = false;
                 else if (strcmp(arg, "no-empty") == 0)
                   flag_empty = false;
                 else if (strcmp(arg, "no-encoding") == 0)
@@ -5783,7 +6309,7 @@ void options(std::list<std::pair<CNF::PATTERN,const char*>>& pattern_args, int a
                 else if (strcmp(arg, "neg-regexp") == 0)
                   usage("missing argument for --", arg);
                 else
-                  usage("invalid option --", arg, "--neg-regexp=, --not, --no-any-line, --no-ascii, --no-binary, --no-bool, --no-break, --no-byte-offset, --no-color, --no-config, --no-confirm, --no-count, --no-decompress, --no-dereference, --no-dereference-files, --no-dotall, --no-encoding, --no-empty, --no-filename, --no-files-with-matches, --no-filter, --no-glob-ignore-case, --no-group-separator, --no-heading, --no-hidden, --no-hyperlink, --no-ignore-binary, --no-ignore-case, --no-ignore-files, --no-index, --no-initial-tab, --no-invert-match, --no-line-number, --no-only-line-number, --no-only-matching, --no-messages, --no-mmap, --no-pager, --no-pretty, --no-smart-case, --no-sort, --no-split, --no-stats, --no-tree, --no-ungroup, --no-view, --null or --null-data");
+                  usage("invalid option --", arg, "--neg-regexp=, --not, --no-any-line, --no-ascii, --no-binary, --no-bool, --no-break, --no-byte-offset, --no-color, --no-config, --no-confirm, --no-count, --no-decompress, --no-dereference, --no-dereference-files, --no-dotall, --no-drop-cache, --no-encoding, --no-empty, --no-filename, --no-files-with-matches, --no-filter, --no-glob-ignore-case, --no-group-separator, --no-heading, --no-hidden, --no-hyperlink, --no-ignore-binary, --no-ignore-case, --no-ignore-files, --no-index, --no-initial-tab, --no-invert-match, --no-line-number, --no-only-line-number, --no-only-matching, --no-messages, --no-mmap, --no-pager, --no-pretty, --no-smart-case, --no-sort, --no-split, --no-stats, --no-tree, --no-ungroup, --no-view, --null or --null-data");
                 break;
 
               case 'o':
@@ -5826,6 +6352,14 @@ void options(std::list<std::pair<CNF::PATTERN,const char*>>& pattern_args, int a
               case 'r':
                 if (strncmp(arg, "range=", 6) == 0)
                   strtopos2(getloptarg(argc, argv, arg + 6, i), flag_min_line, flag_max_line, "invalid argument --range=");
+                else if (strncmp(arg, "read-order=", 11) == 0)
+                  flag_read_order = strarg(getloptarg(argc, argv, arg + 11, i));
+                else if (strcmp(arg, "records") == 0)
+                  flag_records = true;
+                else if (strcmp(arg, "records=spans") == 0)
+                  flag_records = flag_records_spans = true;
+                else if (strncmp(arg, "records=", 8) == 0)
+                  usage("invalid argument --records=WHAT, valid argument is 'spans'");
                 else if (strcmp(arg, "recursive") == 0)
                   flag_directories = "recurse";
                 else if (strcmp(arg, "regexp") == 0) // legacy form --regexp PATTERN
@@ -5835,10 +6369,11 @@ void options(std::list<std::pair<CNF::PATTERN,const char*>>& pattern_args, int a
                 else if (strncmp(arg, "replace=", 8) == 0)
                   flag_replace = strarg(getloptarg(argc, argv, arg + 8, i));
                 else if (strcmp(arg, "range") == 0 ||
+                    strcmp(arg, "read-order") == 0 ||
                     strcmp(arg, "replace") == 0)
                   usage("missing argument for --", arg);
                 else
-                  usage("invalid option --", arg, "--range=, --recursive, --regexp= or --replace=");
+                  usage("invalid option --", arg, "--range=, --read-order=, --records, --recursive, --regexp= or --replace=");
                 break;
 
               case 's':
@@ -5858,14 +6393,18 @@ void options(std::list<std::pair<CNF::PATTERN,const char*>>& pattern_args, int a
                   flag_sort = "name";
                 else if (strncmp(arg, "sort=", 5) == 0)
                   flag_sort = strarg(getloptarg(argc, argv, arg + 5, i));
+                else if (strncmp(arg, "sort-buffer=", 12) == 0)
+                  flag_sort_buffer = strtosize(getloptarg(argc, argv, arg + 12, i), "invalid argument --sort-buffer=");
                 else if (strcmp(arg, "split") == 0)
                   flag_split = true;
                 else if (strcmp(arg, "stats") == 0)
                   flag_stats = "";
                 else if (strncmp(arg, "stats=", 6) == 0)
                   flag_stats = strarg(arg + 6);
+                else if (strcmp(arg, "sort-buffer") == 0)
+                  usage("missing argument for --", arg);
                 else
-                  usage("invalid option --", arg, "--save-config, --separator, --silent, --smart-case, --sort, --split or --stats");
+                  usage("invalid option --", arg, "--save-config, --separator, --silent, --smart-case, --sort, --sort-buffer=, --split or --stats");
                 break;
 
               case 't':
@@ -5879,10 +6418,14 @@ void options(std::list<std::pair<CNF::PATTERN,const char*>>& pattern_args, int a
                   flag_tag = strarg(getloptarg(argc, argv, arg + 4, i));
                 else if (strcmp(arg, "text") == 0)
                   flag_binary_files = "text";
+                else if (strncmp(arg, "trace=", 6) == 0)
+                  flag_trace = getloptarg(argc, argv, arg + 6, i);
                 else if (strcmp(arg, "tree") == 0)
                   flag_tree = true;
+                else if (strcmp(arg, "trace") == 0)
+                  usage("missing argument for --", arg);
                 else
-                  usage("invalid option --", arg, "--tabs, --tag, --text or --tree");
+                  usage("invalid option --", arg, "--tabs, --tag, --text, --trace= or --tree");
                 break;
 
               case 'u':
@@ -7106,6 +7649,14 @@ void init(int argc, const char **argv)
     flag_format_close = "  </file>\n";
     flag_format_end   = "</grep>\n";
   }
+  else if (flag_records)
+  {
+    flag_format_begin = Output::RECORDS_BEGIN;
+    flag_format_open  = Output::RECORDS_OPEN;
+    flag_format       = Output::RECORDS_MATCH;
+    flag_format_close = NULL;
+    flag_format_end   = Output::RECORDS_END;
+  }
   else if (flag_only_line_number)
   {
     flag_format_open  = "%[fn]=%+%=";
@@ -7958,6 +8509,69 @@ void set_terminal_hyperlink()
   }
 }
 
+// --cache: the key of the regex, the CNF and the options that determine which files match, returns false when files that did not match cannot be skipped
+static bool cached_key(std::string& key, const std::string& regex)
+{
+  // -v, -c, -y and -L output files that do not match, --query reuses the files selected to search again
+  if (flag_invert_match || flag_count || flag_any_line || flag_files_without_match || flag_query)
+    return false;
+
+  key.assign(regex).push_back('\n');
+
+  for (const auto& term : Static::bcnf.lists())
+  {
+    for (const auto& pattern : term)
+    {
+      if (pattern)
+        key.append(*pattern);
+      key.push_back('\0');
+    }
+    key.push_back('\n');
+  }
+
+  key.push_back(flag_ignore_case ? '1' : '0');
+  key.push_back(flag_smart_case ? '1' : '0');
+  key.push_back(flag_word_regexp ? '1' : '0');
+  key.push_back(flag_line_regexp ? '1' : '0');
+  key.push_back(flag_fixed_strings ? '1' : '0');
+  key.push_back(flag_basic_regexp ? '1' : '0');
+  key.push_back(flag_perl_regexp ? '1' : '0');
+  key.push_back(flag_bool ? '1' : '0');
+  key.push_back(flag_files ? '1' : '0');
+  key.push_back(flag_binary ? '1' : '0');
+  key.push_back(flag_binary_without_match ? '1' : '0');
+  key.push_back(flag_text ? '1' : '0');
+  key.push_back(flag_dotall ? '1' : '0');
+  key.push_back(flag_free_space ? '1' : '0');
+  key.push_back(flag_empty ? '1' : '0');
+  key.push_back(flag_match ? '1' : '0');
+  key.push_back(flag_null_data ? '1' : '0');
+  key.push_back(flag_decompress ? '1' : '0');
+
+  char options[128];
+  snprintf(options, sizeof(options), " %zu %zu %zu %zu %zu %d\n", flag_min_count, flag_min_line, flag_max_line, flag_fuzzy, flag_zmax, static_cast<int>(flag_encoding_type));
+  key.append(options);
+  key.append(flag_filter).push_back('\n');
+
+  for (const auto& label : flag_filter_magic_label)
+    key.append(label).push_back('\0');
+  key.push_back('\n');
+
+  // -z: the --include and --exclude globs also select the files in archives to search
+  if (flag_decompress)
+  {
+    for (const auto& glob : flag_all_include)
+      key.append(glob).push_back('\0');
+    key.push_back('\n');
+
+    for (const auto& glob : flag_all_exclude)
+      key.append(glob).push_back('\0');
+    key.push_back('\n');
+  }
+
+  return true;
+}
+
 // search the specified files, directories, and/or standard input for pattern matches, may throw an exception
 void ugrep()
 {
@@ -7973,6 +8587,9 @@ void ugrep()
   flag_all_include.clear();
   flag_all_exclude_dir.clear();
   flag_all_include_dir.clear();
+  all_exclude_globs.clear();
+  all_include_globs.clear();
+  all_exclude_dir_globs.clear();
 
   // --iglob: add case-insensitive globs to all-include-iglob/all-exclude-iglob if not --glob-ignore-case
   for (const auto& globs : flag_iglob)
@@ -8348,6 +8965,56 @@ void ugrep()
       usage("invalid argument --sort=KEY, valid arguments are 'name', 'best', 'size', 'used' ('atime'), 'changed' ('mtime'), 'created' ('ctime'), 'list', 'rname', 'rbest', 'rsize', 'rused' ('ratime'), 'rchanged' ('rmtime'), 'rcreated' ('rctime') and 'rlist'");
   }
 
+  // --read-order: check ORDER and set flags
+  if (flag_read_order != NULL)
+  {
+    if (strcmp(flag_read_order, "inode") == 0)
+      flag_read_order_key = Order::INODE;
+    else if (strcmp(flag_read_order, "extent") == 0)
+      flag_read_order_key = Order::EXTENT;
+    else if (strcmp(flag_read_order, "size") == 0)
+      flag_read_order_key = Order::SIZE;
+    else
+      usage("invalid argument --read-order=ORDER, valid arguments are 'inode', 'extent' and 'size'");
+  }
+
+  // --stats: check WHAT and time the phases of the search with --stats=phases and --stats=json
+  Stats::timing = false;
+  if (flag_stats != NULL)
+  {
+    if (strcmp(flag_stats, "phases") == 0 || strcmp(flag_stats, "json") == 0)
+      Stats::timing = true;
+    else if (*flag_stats != '\0' && strcmp(flag_stats, "vm") != 0)
+      usage("invalid argument --stats=WHAT, valid arguments are 'phases', 'json' and 'vm'");
+  }
+
+  // --trace=FILE: record a timeline of the phases of the search per thread
+  if (flag_trace != NULL)
+  {
+    FILE *file = NULL;
+
+    if (fopen_smart(&file, flag_trace, "w") != 0)
+      usage("cannot create trace file ", flag_trace);
+
+    Stats::timing = true;
+    Trace::open(file);
+  }
+
+  // --format, --format-open, --format-close, --format-begin, --format-end and --replace: compile FORMAT once to output formatted matches
+  Output::Format::clear();
+  if (!Output::Format::add(flag_format))
+    usage("invalid argument --format=FORMAT, unterminated %[ARG] in ", flag_format);
+  if (!Output::Format::add(flag_format_open))
+    usage("invalid argument --format-open=FORMAT, unterminated %[ARG] in ", flag_format_open);
+  if (!Output::Format::add(flag_format_close))
+    usage("invalid argument --format-close=FORMAT, unterminated %[ARG] in ", flag_format_close);
+  if (!Output::Format::add(flag_format_begin))
+    usage("invalid argument --format-begin=FORMAT, unterminated %[ARG] in ", flag_format_begin);
+  if (!Output::Format::add(flag_format_end))
+    usage("invalid argument --format-end=FORMAT, unterminated %[ARG] in ", flag_format_end);
+  if (!Output::Format::add(flag_replace))
+    usage("invalid argument --replace=FORMAT, unterminated %[ARG] in ", flag_replace);
+
   // add PATTERN to the CNF
   if (Static::arg_pattern != NULL)
     Static::bcnf.new_pattern(CNF::PATTERN::ALT, Static::arg_pattern);
@@ -8804,6 +9471,17 @@ void ugrep()
   if (flag_tabs)
     matcher_options.append("T=").push_back(static_cast<char>(flag_tabs) + '0');
 
+#ifndef OS_WIN_OR_MINGW
+  // --cache=FILE: skip files that did not match the same search before, and record the files that do not match
+  if (flag_cache != NULL)
+  {
+    std::string key;
+
+    if (cached_key(key, regex))
+      Cache::open(flag_cache, key);
+  }
+#endif
+
   // --format-begin
   if (flag_format_begin != NULL)
     Output(Static::output).format(flag_format_begin, 0);
@@ -9134,6 +9812,10 @@ void ugrep()
     }
   }
 
+  // --query: all selected files were searched and the files that matched are complete, unless the TUI cancels the search
+  Static::selected.searched = Static::selected.matching;
+  Static::selected.matching = false;
+
   // --tree with -l or -c but not --format: finish tree output
   if (flag_tree && (flag_files_with_matches || flag_count) && flag_format == NULL)
   {
@@ -9147,13 +9829,26 @@ void ugrep()
   if (flag_format_end != NULL)
     Output(Static::output).format(flag_format_end, Stats::found_parts());
 
+  // --cache=FILE: save the files that did not match when we're done
+  Cache::close();
+
+  // --trace=FILE: write the timeline of the search when we're done
+  Trace::close();
+
   // --stats: output stats when we're done
-  if (flag_stats != NULL)
+  if (flag_stats != NULL && strcmp(flag_stats, "json") == 0)
+  {
+    Stats::report_json(Static::output);
+  }
+  else if (flag_stats != NULL)
   {
     Stats::report(Static::output);
 
     Static::bcnf.report(Static::output);
 
+    if (strcmp(flag_stats, "phases") == 0)
+      Stats::report_phases(Static::output);
+
     if (strcmp(flag_stats, "vm") == 0)
     {
       size_t nodes = Static::reflex_pattern.nodes();
@@ -9170,6 +9865,10 @@ void ugrep()
       if (hashes > 0)
         fprintf(Static::output, " %zu hash tables (%zums)", hashes, study_time);
       fprintf(Static::output, NEWLINESTR);
+
+#if defined(WITH_MATCHER_STATS)
+      Stats::report_advance(Static::output);
+#endif
     }
   }
 
@@ -9233,6 +9932,99 @@ void Static::cancel_ugrep()
   lock.unlock();
 }
 
+// --query: append a list of globs or pathnames to the key of the file and directory options
+static void selected_key_append(std::string& key, const std::vector<std::string>& list)
+{
+  for (const auto& item : list)
+    key.append(item).push_back('\0');
+  key.push_back('\n');
+}
+
+// --query: the key of the file and directory options that select files to search, returns false when the selected files cannot be reused
+static bool selected_key(std::string& key)
+{
+  // -Z with --sort=best, --index and --stats select or count files depending on the pattern
+  if ((flag_fuzzy > 0 && flag_sort_key == Sort::BEST) || flag_index != NULL || flag_stats != NULL)
+    return false;
+
+  key.clear();
+
+  for (const auto pathname : Static::arg_files)
+    key.append(pathname).push_back('\0');
+  key.push_back('\n');
+
+  selected_key_append(key, flag_all_include);
+  selected_key_append(key, flag_all_include_dir);
+  selected_key_append(key, flag_all_exclude);
+  selected_key_append(key, flag_all_exclude_dir);
+  selected_key_append(key, flag_file_magic);
+  selected_key_append(key, flag_include_fs);
+  selected_key_append(key, flag_exclude_fs);
+
+  for (const auto& ignore : flag_ignore_files)
+    key.append(ignore).push_back('\0');
+  key.push_back('\n');
+
+  char options[256];
+  snprintf(options, sizeof(options), "%d%d%d%d%d%d %d %d %d %d %d %zu %zu %zu %zu %zu %zu %zu %zu",
+      flag_hidden,
+      flag_dereference,
+      flag_dereference_files,
+      flag_no_dereference,
+      flag_decompress,
+      flag_sort_rev,
+      static_cast<int>(flag_sort_key),
+      static_cast<int>(flag_read_order_key),
+      static_cast<int>(flag_directories_action),
+      static_cast<int>(flag_devices_action),
+      static_cast<int>(flag_encoding_type),
+      flag_min_depth,
+      flag_max_depth,
+      flag_min_size,
+      flag_max_size,
+      flag_include_iglob_size,
+      flag_include_iglob_dir_size,
+      flag_exclude_iglob_size,
+      flag_exclude_iglob_dir_size);
+  key.append(options);
+
+  return true;
+}
+
+// --query: the key of the options that determine which files match, returns false when a refined query may match files that did not match
+static bool matched_key(std::string& key)
+{
+  // -v, -c, -y and -L output files that do not match, -Z matches approximately, -f and --max-files search a subset
+  if (flag_invert_match || flag_count || flag_any_line || flag_files_without_match || flag_fuzzy > 0 || !flag_file.empty() || flag_max_files > 0)
+    return false;
+
+  key.clear();
+  key.push_back(flag_ignore_case ? '1' : '0');
+  key.push_back(flag_smart_case ? '1' : '0');
+  key.push_back(flag_word_regexp ? '1' : '0');
+  key.push_back(flag_line_regexp ? '1' : '0');
+  key.push_back(flag_fixed_strings ? '1' : '0');
+  key.push_back(flag_basic_regexp ? '1' : '0');
+  key.push_back(flag_perl_regexp ? '1' : '0');
+  key.push_back(flag_bool ? '1' : '0');
+  key.push_back(flag_files ? '1' : '0');
+  key.push_back(flag_binary ? '1' : '0');
+  key.push_back(flag_binary_without_match ? '1' : '0');
+  key.push_back(flag_text ? '1' : '0');
+  key.push_back(flag_dotall ? '1' : '0');
+  key.push_back(flag_free_space ? '1' : '0');
+  key.push_back(flag_empty ? '1' : '0');
+  key.push_back(flag_match ? '1' : '0');
+  key.push_back(flag_null_data ? '1' : '0');
+
+  char options[64];
+  snprintf(options, sizeof(options), " %zu %zu %zu", flag_min_count, flag_min_line, flag_max_line);
+  key.append(options);
+  key.append(flag_filter);
+
+  return true;
+}
+
 // search the specified files or standard input for pattern matches
 void Grep::ugrep()
 {
@@ -9245,6 +10037,59 @@ void Grep::ugrep()
     search(Static::LABEL_STANDARD_INPUT, static_cast<uint16_t>(flag_fuzzy));
   }
 
+  // --query: search the files selected by the last search when the file and directory options are the same, without traversing directories again
+  std::string key;
+  bool caching = flag_query && selected_key(key);
+
+  // --query: a query that refines the last query that searched all selected files only searches the files that matched
+  std::string options;
+  bool matching = caching && matched_key(options);
+  bool narrowing = matching && Static::selected.searched && Static::selected.options == options && Static::bcnf.implies(Static::selected.cnf);
+
+  // --query: add the files that match this query to narrow the search of the next query
+  std::set<std::string> matched;
+
+  if (flag_query)
+  {
+    matched.swap(Static::selected.matched);
+    Static::selected.cnf.assign(Static::bcnf);
+    Static::selected.options.swap(options);
+    Static::selected.matching = matching;
+    Static::selected.searched = false;
+  }
+
+  if (caching && Static::selected.complete && Static::selected.key == key)
+  {
+    Stats::score_dirs(Static::selected.dirs);
+
+    for (const auto& pathname : Static::selected.files)
+    {
+      // stop after finding max-files matching files
+      if (flag_max_files > 0 && Stats::found_parts() >= flag_max_files)
+        break;
+
+      // stop when output is blocked or search cancelled
+      if (out.eof || out.cancelled())
+        break;
+
+      Stats::score_file();
+
+      // a refined query does not match the files that did not match the last query
+      if (narrowing && matched.find(pathname) == matched.end())
+        continue;
+
+      search(pathname.c_str(), Entry::UNDEFINED_COST);
+    }
+
+    return;
+  }
+
+  // --query: select files to search by traversing directories and add them to the files selected
+  Static::selected.key.swap(key);
+  Static::selected.files.clear();
+  Static::selected.caching = caching;
+  Static::selected.complete = false;
+
   if (Static::arg_files.empty())
   {
     if (flag_directories_action == Action::RECURSE)
@@ -9300,6 +10145,7 @@ void Grep::ugrep()
           break;
 
         case Type::OTHER:
+          cache_selected(pathname);
           search(pathname, Entry::UNDEFINED_COST);
           break;
 
@@ -9308,11 +10154,23 @@ void Grep::ugrep()
       }
     }
   }
+
+  // --query: the files selected are complete when all directories were traversed
+  if (caching)
+  {
+    Static::selected.caching = false;
+    Static::selected.dirs = Stats::searched_dirs();
+    Static::selected.complete = !out.eof && !out.cancelled() && (flag_max_files == 0 || Stats::found_parts() < flag_max_files);
+  }
 }
 
 // select file or directory to search for pattern matches, return SKIP, DIRECTORY or OTHER
 Grep::Type Grep::select(size_t level, const char *pathname, const char *basename, int type, uint32_t attr, ino_t& inode, uint64_t& info, bool is_argument)
 {
+  // --stats=phases: time selecting pathnames by glob and ignore filtering
+  Stats::Timer timer(Stats::SELECT);
+  Stats::score_phase(Stats::SELECT, 1);
+
   if (*basename == '.' && !flag_hidden && !is_argument)
     return Type::SKIP;
 
@@ -9364,21 +10222,8 @@ Grep::Type Grep::select(size_t level, const char *pathname, const char *basename
         if (!flag_all_exclude_dir.empty())
         {
           // exclude directories whose pathname matches any one of the --exclude-dir globs unless negated with !
-          bool ok = true;
-          for (const auto& glob : flag_all_exclude_dir)
-          {
-            bool ignore_case = &glob < &flag_all_exclude_dir.front() + flag_exclude_iglob_size;
-            if (glob.front() == '!')
-            {
-              if (!ok && glob_match(pathname, basename, glob.c_str() + 1, ignore_case))
-                ok = true;
-            }
-            else if (ok && glob_match(pathname, basename, glob.c_str(), ignore_case))
-            {
-              ok = false;
-            }
-          }
-          if (!ok)
+          size_t last = all_exclude_dir_globs.last(pathname, basename);
+          if (last > 0 && flag_all_exclude_dir[last - 1].front() != '!')
             return Type::SKIP;
         }
 
@@ -9439,40 +10284,16 @@ Grep::Type Grep::select(size_t level, const char *pathname, const char *basename
     if (!flag_all_exclude.empty())
     {
       // exclude files whose pathname matches any one of the --exclude globs unless negated with !
-      for (const auto& glob : flag_all_exclude)
-      {
-        bool ignore_case = &glob < &flag_all_exclude.front() + flag_exclude_iglob_size;
-        if (glob.front() == '!')
-        {
-          if (!ok && glob_match(pathname, basename, glob.c_str() + 1, ignore_case))
-            ok = true;
-        }
-        else if (ok && glob_match(pathname, basename, glob.c_str(), ignore_case))
-        {
-          ok = false;
-        }
-      }
-      if (!ok)
+      size_t last = all_exclude_globs.last(pathname, basename);
+      if (last > 0 && flag_all_exclude[last - 1].front() != '!')
         return Type::SKIP;
     }
 
     if (!flag_all_include.empty())
     {
       // include files whose pathname matches any one of the --include globs unless negated with !
-      ok = false;
-      for (const auto& glob : flag_all_include)
-      {
-        bool ignore_case = &glob < &flag_all_include.front() + flag_include_iglob_size;
-        if (glob.front() == '!')
-        {
-          if (ok && glob_match(pathname, basename, glob.c_str() + 1), ignore_case)
-            ok = false;
-        }
-        else if (!ok && glob_match(pathname, basename, glob.c_str(), ignore_case))
-        {
-          ok = true;
-        }
-      }
+      size_t last = all_include_globs.last(pathname, basename);
+      ok = last > 0 && flag_all_include[last - 1].front() != '!';
       if (!ok && flag_file_magic.empty())
         return Type::SKIP;
     }
@@ -9539,7 +10360,7 @@ Grep::Type Grep::select(size_t level, const char *pathname, const char *basename
   bool follow = flag_dereference || is_argument;
 
   // if dir entry is unknown and not following, then use lstat() to check if pathname is a symlink
-  if (type != DIRENT_TYPE_UNKNOWN || follow || lstat(pathname, &buf) == 0)
+  if (type != DIRENT_TYPE_UNKNOWN || follow || directory.stat(pathname, basename, false, buf) == 0)
   {
     // is it a symlink? If dir entry unknown and following then set to symlink = true to call stat() below
     bool symlink = type != DIRENT_TYPE_UNKNOWN ? type == DIRENT_TYPE_LNK : follow ? true : S_ISLNK(buf.st_mode);
@@ -9547,9 +10368,9 @@ Grep::Type Grep::select(size_t level, const char *pathname, const char *basename
     if (( ( (type != DIRENT_TYPE_UNKNOWN && type != DIRENT_TYPE_LNK) ||    // type is known and not symlink
             (!follow && !symlink)                                          // or not following and not symlink
           ) &&
-          (flag_sort_key == Sort::NA || flag_sort_key == Sort::NAME)       // and we're not sorting or by name
+          ((flag_sort_key == Sort::NA && flag_read_order_key != Order::SIZE) || flag_sort_key == Sort::NAME) // and we're not sorting or by name
         ) ||
-        stat(pathname, &buf) == 0)                                      // otherwise, do a stat
+        directory.stat(pathname, basename, true, buf) == 0)             // otherwise, do a stat
     {
       // check if directory
       if (type == DIRENT_TYPE_DIR || ((type == DIRENT_TYPE_UNKNOWN || type == DIRENT_TYPE_LNK) && S_ISDIR(buf.st_mode)))
@@ -9584,21 +10405,8 @@ Grep::Type Grep::select(size_t level, const char *pathname, const char *basename
               if (!flag_all_exclude_dir.empty())
               {
                 // exclude directories whose pathname matches any one of the --exclude-dir globs unless negated with !
-                bool ok = true;
-                for (const auto& glob : flag_all_exclude_dir)
-                {
-                  bool ignore_case = &glob < &flag_all_exclude_dir.front() + flag_exclude_iglob_dir_size;
-                  if (glob.front() == '!')
-                  {
-                    if (!ok && glob_match(pathname, basename, glob.c_str() + 1, ignore_case))
-                      ok = true;
-                  }
-                  else if (ok && glob_match(pathname, basename, glob.c_str(), ignore_case))
-                  {
-                    ok = false;
-                  }
-                }
-                if (!ok)
+                size_t last = all_exclude_dir_globs.last(pathname, basename);
+                if (last > 0 && flag_all_exclude_dir[last - 1].front() != '!')
                   return Type::SKIP;
               }
 
@@ -9668,53 +10476,35 @@ Grep::Type Grep::select(size_t level, const char *pathname, const char *basename
           if (!flag_all_exclude.empty())
           {
             // exclude files whose pathname matches any one of the --exclude globs unless negated with !
-            for (const auto& glob : flag_all_exclude)
-            {
-              bool ignore_case = &glob < &flag_all_exclude.front() + flag_exclude_iglob_size;
-              if (glob.front() == '!')
-              {
-                if (!ok && glob_match(pathname, basename, glob.c_str() + 1, ignore_case))
-                  ok = true;
-              }
-              else if (ok && glob_match(pathname, basename, glob.c_str(), ignore_case))
-              {
-                ok = false;
-              }
-            }
-            if (!ok)
+            size_t last = all_exclude_globs.last(pathname, basename);
+            if (last > 0 && flag_all_exclude[last - 1].front() != '!')
               return Type::SKIP;
           }
 
           if (!flag_all_include.empty())
           {
             // include files whose basename matches any one of the --include globs if not negated with !
-            ok = false;
-            for (const auto& glob : flag_all_include)
-            {
-              bool ignore_case = &glob < &flag_all_include.front() + flag_include_iglob_size;
-              if (glob.front() == '!')
-              {
-                if (ok && glob_match(pathname, basename, glob.c_str() + 1, ignore_case))
-                  ok = false;
-              }
-              else if (!ok && glob_match(pathname, basename, glob.c_str(), ignore_case))
-              {
-                ok = true;
-              }
-            }
+            size_t last = all_include_globs.last(pathname, basename);
+            ok = last > 0 && flag_all_include[last - 1].front() != '!';
             if (!ok && flag_file_magic.empty())
               return Type::SKIP;
           }
 
+          // if stat not done then do it to get the size for --min-size and --max-size and the size and times for --cache
+          if ((flag_min_size != 0 || flag_max_size != 0 || Cache::enabled) && type == DIRENT_TYPE_REG && ((flag_sort_key == Sort::NA && flag_read_order_key != Order::SIZE) || flag_sort_key == Sort::NAME))
+            if (directory.stat(pathname, basename, true, buf) != 0)
+              memset(&buf, 0, sizeof(buf));
+
           // --min-size, --max-size: skip regular files that are too small or too large
           if (flag_min_size != 0 || flag_max_size != 0)
-          {
-            // if stat not done then do it to get size
-            if (type == DIRENT_TYPE_REG && (flag_sort_key == Sort::NA || flag_sort_key == Sort::NAME))
-              stat(pathname, &buf);
-
             if (buf.st_size < static_cast<off_t>(flag_min_size) || (flag_max_size > 0 && buf.st_size > static_cast<off_t>(flag_max_size)))
               return Type::SKIP;
+
+          // --cache: skip files that did not match the same search before and did not change, like skipping files with --index
+          if (Cache::enabled && Cache::skip(buf))
+          {
+            Stats::score_file();
+            return Type::SKIP;
           }
 
           // check magic pattern against the file signature, when --file-magic=MAGIC is specified
@@ -9795,6 +10585,9 @@ void Grep::recurse(size_t level, const char *pathname)
   if (out.eof || out.cancelled())
     return;
 
+  // --stats=phases: time reading directories
+  Stats::Timer timer(Stats::TRAVERSE);
+
 #ifdef OS_WIN_OR_MINGW
 
   WIN32_FIND_DATAW ffd;
@@ -9836,9 +10629,8 @@ void Grep::recurse(size_t level, const char *pathname)
 
 #endif
 
-  DIR *dir = opendir(pathname);
-
-  if (dir == NULL)
+  // read the directory with getdents64() on Linux, otherwise with readdir()
+  if (!directory.open(pathname))
   {
     warning("cannot open directory", pathname);
     return;
@@ -9882,7 +10674,13 @@ void Grep::recurse(size_t level, const char *pathname)
         Stats::ignore_file(ignore_filename);
 
         // push globs imported from the ignore file to the back of the vectors
-        import_globs(file, flag_all_exclude, flag_all_exclude_dir, true, pathname);
+        size_t exclude_size = flag_all_exclude.size();
+        size_t exclude_dir_size = flag_all_exclude_dir.size();
+        Ignored& ignored = import_ignore_file(file, ignore_filename, pathname);
+        flag_all_exclude.insert(flag_all_exclude.end(), ignored.files.begin(), ignored.files.end());
+        flag_all_exclude_dir.insert(flag_all_exclude_dir.end(), ignored.dirs.begin(), ignored.dirs.end());
+        all_exclude_globs.extend(exclude_size, ignored.files_set);
+        all_exclude_dir_globs.extend(exclude_dir_size, ignored.dirs_set);
 
         fclose(file);
       }
@@ -9903,6 +10701,8 @@ void Grep::recurse(size_t level, const char *pathname)
 
   do
   {
+    Stats::score_phase(Stats::TRAVERSE, 1);
+
     cFileName.assign(utf8_encode(ffd.cFileName));
 
     // search directory entries that aren't . or .. or hidden
@@ -10117,7 +10917,10 @@ void Grep::recurse(size_t level, const char *pathname)
 
         case Type::OTHER:
           if (flag_sort_key == Sort::NA)
+          {
+            cache_selected(entry_pathname.c_str());
             search(entry_pathname.c_str(), Entry::UNDEFINED_COST);
+          }
           else
             file_entries.emplace_back(entry_pathname, 0, info);
           break;
@@ -10140,11 +10943,13 @@ void Grep::recurse(size_t level, const char *pathname)
 
 #else
 
-  struct dirent *dirent = NULL;
+  const Directory::Dirent *dirent = NULL;
   uint64_t list = 0;
 
-  while ((dirent = readdir(dir)) != NULL)
+  while ((dirent = directory.read()) != NULL)
   {
+    Stats::score_phase(Stats::TRAVERSE, 1);
+
     // search directory entries that aren't . or .. or hidden
     if (dirent->d_name[0] != '.' || (flag_hidden && dirent->d_name[1] != '\0' && dirent->d_name[1] != '.'))
     {
@@ -10263,7 +11068,7 @@ void Grep::recurse(size_t level, const char *pathname)
                         index_pathname.assign(pathname).append(PATHSEPSTR).append(buffer, basename_size);
 
                       // does the file exist and was changed after indexing?
-                      is_changed = stat(index_pathname.c_str(), &buf) == 0 && Entry::modified_time(buf) > index_time;
+                      is_changed = directory.stat(index_pathname.c_str(), buffer, true, buf, true) == 0 && Entry::modified_time(buf) > index_time;
 
                       if (is_changed)
                       {
@@ -10351,10 +11156,24 @@ void Grep::recurse(size_t level, const char *pathname)
           break;
 
         case Type::OTHER:
-          if (flag_sort_key == Sort::NA)
+          if (flag_sort_key == Sort::NA && flag_read_order_key == Order::NA)
+          {
+            cache_selected(entry_pathname.c_str());
             search(entry_pathname.c_str(), Entry::UNDEFINED_COST);
+          }
+          else if (flag_sort_key == Sort::NA && flag_read_order_key == Order::SIZE)
+          {
+            // --read-order=size without --sort: info is the file size to schedule the largest files first
+            cache_selected(entry_pathname.c_str());
+            schedule(entry_pathname, info);
+          }
           else
+          {
+            // --read-order without --sort: search files in inode order or in the order of their first extent on disk
+            if (flag_sort_key == Sort::NA)
+              info = flag_read_order_key == Order::INODE ? static_cast<uint64_t>(inode) : directory.extent(entry_pathname.c_str(), dirent->d_name, inode);
             file_entries.emplace_back(entry_pathname, inode, info);
+          }
           break;
 
         case Type::SKIP:
@@ -10371,8 +11190,7 @@ void Grep::recurse(size_t level, const char *pathname)
     }
   }
 
-  closedir(dir);
-  dir = NULL;
+  directory.close();
 
 #endif
 
@@ -10392,10 +11210,14 @@ void Grep::recurse(size_t level, const char *pathname)
     }
   }
 
-  // --sort: sort the selected non-directory entries and search them
-  if (flag_sort_key != Sort::NA)
+  // --sort or --read-order: sort the selected non-directory entries and search them
+  if (flag_sort_key != Sort::NA || flag_read_order_key != Order::NA)
   {
-    if (flag_sort_key == Sort::NAME)
+    if (flag_sort_key == Sort::NA)
+    {
+      std::sort(file_entries.begin(), file_entries.end(), Entry::comp_by_info);
+    }
+    else if (flag_sort_key == Sort::NAME)
     {
       if (flag_sort_rev)
         std::sort(file_entries.begin(), file_entries.end(), Entry::rev_comp_by_path);
@@ -10420,6 +11242,7 @@ void Grep::recurse(size_t level, const char *pathname)
     // search the select sorted non-directory entries
     for (const auto& entry : file_entries)
     {
+      cache_selected(entry.pathname.c_str());
       search(entry.pathname.c_str(), entry.cost);
 
       // stop after finding max-files matching files
@@ -10489,6 +11312,8 @@ void Grep::recurse(size_t level, const char *pathname)
   {
     flag_all_exclude.resize(saved_all_exclude_size);
     flag_all_exclude_dir.resize(saved_all_exclude_dir_size);
+    all_exclude_globs.truncate();
+    all_exclude_dir_globs.truncate();
   }
 }
 
@@ -10564,6 +11389,9 @@ uint16_t Grep::compute_cost(const char *pathname)
 // search input to output the pattern matches
 void Grep::search(const char *pathname, uint16_t cost)
 {
+  // --stats=phases: time searching, excluding the nested phases
+  Stats::Timer timer(Stats::MATCH);
+
   // -Zbest (or --best-match) without --match: compute cost if not yet computed by --sort=best
   if (flag_best_match && flag_fuzzy > 0 && !flag_match && !flag_quiet && (!flag_files_with_matches || flag_format != NULL) && matchers == NULL && pathname != Static::LABEL_STANDARD_INPUT)
   {
@@ -10599,6 +11427,13 @@ void Grep::search(const char *pathname, uint16_t cost)
   if (out.eof)
     return;
 
+#ifndef OS_WIN_OR_MINGW
+  // --cache: stat the file before reading it to record the file when it does not match, a change while reading it changes its times
+  struct stat buf;
+  bool cacheable = Cache::enabled && pathname != Static::LABEL_STANDARD_INPUT && ::stat(pathname, &buf) == 0 && S_ISREG(buf.st_mode);
+  size_t warnings = Static::warnings;
+#endif
+
   try
   {
     // open (archive or compressed) file (pathname is NULL to read stdin), return on failure
@@ -10619,12 +11454,16 @@ void Grep::search(const char *pathname, uint16_t cost)
     pathname = flag_label;
 
   bool matched = false;
+  bool complete = true;
 
   // -z: loop over extracted archive parts, when applicable
   do
   {
     if (!init_read())
+    {
+      complete = false;
       goto exit_search;
+    }
 
     try
     {
@@ -13482,7 +14321,13 @@ done_search:
         out.nl();
 
       if (flag_stats != NULL)
+      {
         Stats::score_matches(matches, matcher->lineno() > 0 ? matcher->lineno() - 1 : 0);
+        Stats::score_phase(Stats::MATCH, matcher->last());
+#if defined(WITH_MATCHER_STATS)
+        Stats::score_advance(matcher);
+#endif
+      }
     }
 
     catch (EXIT_SEARCH&)
@@ -13494,6 +14339,7 @@ done_search:
     {
       // this should never happen
       warning("exception while searching", pathname);
+      complete = false;
     }
 
 exit_search:
@@ -13506,7 +14352,25 @@ exit_search:
 
   // this file or archive has a match
   if (matched)
+  {
     Stats::found_file();
+
+    // --query: add the file to the files that matched to narrow the search of a refined query
+    if (Static::selected.matching)
+    {
+      std::unique_lock<std::mutex> lock(Static::selected.mutex);
+      Static::selected.matched.emplace(pathname);
+    }
+  }
+#ifndef OS_WIN_OR_MINGW
+  else if (cacheable && complete && !out.eof && !out.cancelled() && Static::warnings == warnings && (flag_max_files == 0 || Stats::found_parts() < flag_max_files))
+  {
+    // --cache: record the file that did not match when it was searched completely without warnings, a match is not counted when --max-files or -q stopped the search
+    Cache::record(buf);
+  }
+#else
+  (void)complete;
+#endif
 }
 
 // search input after lineno to populate a string vector with the matching line and lines after up to max lines. used by the TUI
@@ -13686,6 +14550,50 @@ void import_globs(FILE *file, std::vector<std::string>& files, std::vector<std::
   }
 }
 
+// --ignore-files: import the globs of an ignore file or reuse the globs imported before when the ignore file is unchanged
+Ignored& import_ignore_file(FILE *file, const std::string& filename, const char *pathname)
+{
+  Ignored& ignored = ignored_files[filename];
+
+#ifdef OS_WIN_OR_MINGW
+
+  // file modification times may be too coarse to detect changes, always import
+  ignored.files.clear();
+  ignored.dirs.clear();
+  ignored.files_set.reset();
+  ignored.dirs_set.reset();
+
+#else
+
+  struct stat buf;
+
+  if (fstat(fileno(file), &buf) != 0)
+    memset(&buf, 0, sizeof(buf));
+
+  uint64_t device = static_cast<uint64_t>(buf.st_dev);
+  uint64_t inode = static_cast<uint64_t>(buf.st_ino);
+  uint64_t mtime = Grep::Entry::modified_time(buf);
+  uint64_t size = static_cast<uint64_t>(buf.st_size);
+
+  if (inode != 0 && ignored.device == device && ignored.inode == inode && ignored.mtime == mtime && ignored.size == size)
+    return ignored;
+
+  ignored.device = device;
+  ignored.inode = inode;
+  ignored.mtime = mtime;
+  ignored.size = size;
+  ignored.files.clear();
+  ignored.dirs.clear();
+  ignored.files_set.reset();
+  ignored.dirs_set.reset();
+
+#endif
+
+  import_globs(file, ignored.files, ignored.dirs, true, pathname);
+
+  return ignored;
+}
+
 // trim white space from either end of the line
 void trim(std::string& line)
 {
@@ -14151,6 +15059,17 @@ void help(std::ostream& out)
             When -v is specified, counts the number of non-matching lines.\n\
             When -m1, (with a comma or --min-count=1) is specified, counts only\n\
             matching files without outputting zero matches.\n\
+    --cache=FILE\n\
+            Skip files that did not match the same search before and did not\n\
+            change since, as recorded in the cache FILE.  Files searched that\n\
+            did not match are recorded in FILE when the search ends.  A file is\n\
+            unchanged when its inode number, size, modification time and status\n\
+            change time are the same.  FILE keeps the files of the most recent\n\
+            searches with different patterns and options.  Files not searched\n\
+            by the last four searches with the same patterns and options are\n\
+            dropped from FILE.  This option has no effect with -c, -L, -v, -y\n\
+            and -Q.  Option --stats displays the number of files skipped, the\n\
+            cache misses and the files changed.\n\
     --color[=WHEN], --colour[=WHEN]\n\
             Mark up the matching text with the colors specified with option\n\
             --colors or the GREP_COLOR or GREP_COLORS environment variable.\n\
@@ -14217,6 +15136,13 @@ void help(std::ostream& out)
     --dotall\n\
             Dot `.' in regular expressions matches anything, including newline.\n\
             Note that `.*' matches all input and should not be used.\n\
+    --drop-cache\n\
+            Leave the page cache as it was before the search, by dropping the\n\
+            pages of files read that were not cached before.  Pages behind the\n\
+            read position are dropped while searching large files.  Prevents\n\
+            recursive searches from evicting the working set of other processes\n\
+            from the page cache.  Option --stats reports the number of bytes\n\
+            read and the file pages left in the page cache.\n\
     -E, --extended-regexp\n\
             Interpret patterns as extended regular expressions (EREs). This is\n\
             the default.\n\
@@ -14324,10 +15250,15 @@ void help(std::ostream& out)
             the pathname to search.  For example, --filter='pdf:pdftotext % -'\n\
             searches PDF files.  The `%' expands into a `-' when searching\n\
             standard input.  When a `%' is not specified, the filter command\n\
-            should read from standard input and write to standard output.\n\
-            Option --label=.ext may be used to specify extension `ext' when\n\
-            searching standard input.  Note that `exts` filename extension\n\
-            matching is case insensitive.  This option may be repeated.\n\
+            should read from standard input and write to standard output.  A\n\
+            `command' that starts with a `|' is a coprocess that is started\n\
+            once by each search thread to filter the files sent to it.  Each\n\
+            file is sent to its standard input as a 64-bit little-endian length\n\
+            followed by the file contents, and the filtered output is read from\n\
+            its standard output in the same way.  Option --label=.ext may be\n\
+            used to specify extension `ext' when searching standard input.\n\
+            Note that `exts` filename extension matching is case insensitive.\n\
+            This option may be repeated.\n\
     --filter-magic-label=[+]LABEL:MAGIC\n\
             Associate LABEL with files whose signature \"magic bytes\" match the\n\
             MAGIC regex pattern.  Only files that have no filename extension\n\
@@ -14551,7 +15482,9 @@ void help(std::ostream& out)
     --mmap[=MAX]\n\
             Use memory maps to search files.  By default, memory maps are used\n\
             under certain conditions to improve performance.  When MAX is\n\
-            specified, use up to MAX mmap memory per thread.\n\
+            specified, use up to MAX mmap memory per thread.  Files larger\n\
+            than MAX are searched with a memory map window of MAX bytes that\n\
+            slides over the file.\n\
     -N PATTERN, --neg-regexp=PATTERN\n\
             Specify a negative PATTERN to reject specific -e PATTERN matches\n\
             with a counter pattern.  Note that longer patterns take precedence\n\
@@ -14655,6 +15588,23 @@ void help(std::ostream& out)
             links only if they are on the command line.  Note that when no FILE\n\
             arguments are specified and input is read from a terminal,\n\
             recursive searches are performed as if -r is specified.\n\
+    --read-order=ORDER\n\
+            Search the files in a directory in the ORDER they are stored to\n\
+            speed up recursive searches on rotational disks and network\n\
+            storage.  ORDER can be `inode' to search files by inode number,\n\
+            `extent' to search files by the physical location of their first\n\
+            extent on disk or `size' to search the largest files first to\n\
+            balance the work of the worker threads.  Has no effect when --sort\n\
+            is specified.  Option --stats reports the read order and option\n\
+            --stats=phases also reports the read throughput.\n\
+    --records[=spans]\n\
+            Output file matches as compact binary records for machine\n\
+            consumers.  Records are length-prefixed and hold the file id, line\n\
+            number, column number, byte offset and size of a match and the\n\
+            matching line, or the match with -o, without escapes.  File records\n\
+            assign file ids to pathnames.  When `spans' is specified, the\n\
+            matching lines are omitted.  See src/records.hpp in the source\n\
+            distribution for the record format and a reference reader.\n\
     --replace=FORMAT\n\
             Replace matching patterns in the output by FORMAT with `%' fields.\n\
             If -P is specified, FORMAT may include `%1' to `%9', `%[NUM]#' and\n\
@@ -14697,9 +15647,23 @@ void help(std::ostream& out)
             `rsize', `rused', `rchanged', or `rcreated'.  Archive contents are\n\
             not sorted.  Subdirectories are sorted and displayed after matching\n\
             files.  FILE arguments are searched in the same order as specified.\n\
-    --stats\n\
+    --sort-buffer=SIZE\n\
+            When sorting with --sort, output of files that is not yet due is\n\
+            held in memory up to SIZE bytes, then held in a temporary file.\n\
+            SIZE may have a `K', `M' or `G' suffix.  The default is 64M.\n\
+    --stats[=WHAT]\n\
             Output statistics on the number of files and directories searched\n\
-            and the inclusion and exclusion constraints applied.\n\
+            and the inclusion and exclusion constraints applied.  When WHAT is\n\
+            `phases', also output the number of bytes read from regular files\n\
+            and the time spent by all threads in each phase of the search with\n\
+            the throughput per phase: traversing directories, selecting\n\
+            pathnames, opening files, decompressing, matching, evaluating\n\
+            Boolean queries, writing output and waiting for output.  When WHAT\n\
+            is `json', output the statistics and the phases in JSON.  When WHAT\n\
+            is `vm', also output the size of the compiled pattern and, when\n\
+            ugrep is built with --enable-matcher-stats, the search method\n\
+            selected for the pattern with the number of bytes skipped, the\n\
+            possible matches found and the matches verified and found.\n\
     -T, --initial-tab\n\
             Add a tab space to separate the file name, line number, column\n\
             number and byte offset with the matched line.\n\
@@ -14722,6 +15686,12 @@ void help(std::ostream& out)
     --tag[=TAG[,END]]\n\
             Disables colors to mark up matches with TAG.  END marks the end of\n\
             a match if specified, otherwise TAG.  The default is `___'.\n\
+    --trace=FILE\n\
+            Record a timeline of the search in FILE in the Chrome trace event\n\
+            JSON format, to view with Perfetto or chrome://tracing.  The timeline\n\
+            shows the phases of the search per thread, the jobs searched by the\n\
+            worker threads, and the jobs submitted and stolen.  The events are\n\
+            buffered per thread and written to FILE when the search ends.\n\
     --tree, -^\n\
             Output directories with matching files in a tree-like format for\n\
             option -c or --count, -l or --files-with-matches, -L or\n\
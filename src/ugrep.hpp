@@ -170,6 +170,12 @@ inline int pipe_inherit(int fd[2])
   return -1;
 }
 
+// POSIX pipe() emulation with pipe handles that are not inherited by child processes, like pipe2(fd, O_CLOEXEC)
+inline int pipe_cloexec(int fd[2])
+{
+  return pipe(fd);
+}
+
 #ifdef OS_WIN
 
 // POSIX popen()
@@ -373,6 +379,21 @@ inline char *getcwd0()
   return getcwd(NULL, 0);
 }
 
+// POSIX pipe() with close-on-exec pipe ends not inherited by the --filter processes forked by other threads
+inline int pipe_cloexec(int fd[2])
+{
+#if defined(HAVE_PIPE2) && defined(O_CLOEXEC)
+  return pipe2(fd, O_CLOEXEC);
+#else
+  // not atomic, a process forked by another thread in between inherits the pipe ends
+  if (pipe(fd) != 0)
+    return -1;
+  fcntl(fd[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fd[1], F_SETFD, FD_CLOEXEC);
+  return 0;
+#endif
+}
+
 #endif
 
 // UTF-8 multibyte string length (number of UTF-8-encoded Unicode characters) without validity checking
@@ -490,6 +511,11 @@ inline const char *utf8skipn(const char *s, size_t n, size_t k)
 # define DEFAULT_MAX_MMAP_SIZE MAX_MMAP_SIZE
 #endif
 
+// default --sort-buffer: output of --sort held in memory by the writer thread before spilling to a temporary file
+#ifndef DEFAULT_SORT_BUFFER_SIZE
+# define DEFAULT_SORT_BUFFER_SIZE 67108864
+#endif
+
 // pretty is disabled by default for ugrep (but always enabled by ug), unless enabled with WITH_PRETTY
 #ifdef WITH_PRETTY
 # define DEFAULT_PRETTY Static::AUTO
@@ -567,6 +593,22 @@ struct Static {
   static const char *arg_pattern;
   static std::vector<const char*> arg_files;
 
+  // --query: the files selected by the last search, searched again by the next query with the same file and directory options
+  struct Selected {
+    std::string              key;      // the file and directory options that selected the files
+    std::vector<std::string> files;    // the selected files in the order searched
+    size_t                   dirs;     // the number of directories traversed
+    bool                     caching;  // true while selected files are added by the directory traversal
+    bool                     complete; // true if the directory traversal completed
+    CNF                      cnf;      // the CNF of the last search of the selected files
+    std::string              options;  // the options that determine which files matched the CNF
+    std::set<std::string>    matched;  // the selected files that matched the CNF
+    std::mutex               mutex;    // mutex to add matched files
+    bool                     matching; // true while matched files are added by the search
+    bool                     searched; // true if the last search searched all selected files, false when cancelled
+  };
+  static Selected selected;
+
   // number of cores
   static size_t cores;
 
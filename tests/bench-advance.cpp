@@ -0,0 +1,486 @@
+/******************************************************************************\
+* Copyright (c) 2019, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+/**
+@file      bench-advance.cpp
+@brief     microbenchmark of the reflex::Matcher advance search kernels
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2019-2025, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+
+Runs reflex::Matcher::find() over synthetic buffers with a controlled alphabet
+and match density, with patterns chosen to select each advance search kernel,
+and reports the throughput in GB/s of each kernel per CPU feature level.  The
+CPU feature levels are forced by masking the reflex::HW CPU id bits before the
+pattern is analyzed and the matcher selects its kernel.  Level `none' clears
+SSE2 too, which selects the Boyer-Moore string search kernels.
+
+Build and run with `make bench-advance`, or:
+
+  bench-advance [-s MB] [-r RUNS] [-d DENSITY,...] [-a ALPHABET,...] [-k KERNEL]
+
+  -s MB          buffer size in MB, default 16
+  -r RUNS        number of runs per kernel, the fastest run is reported, default 3
+  -d DENSITY     number of matches inserted per MB, default 0,16,1024
+  -a ALPHABET    text, dna or binary, default text,dna,binary
+  -k KERNEL      only run the kernels with names containing KERNEL
+
+The results are output in JSON, with one kernel result per line, followed by
+the kernels compiled in the matcher that the run did not cover.
+
+*/
+
+#include <reflex/matcher.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+// the patterns to benchmark, each selects an advance search kernel, the needle is inserted in the buffer to match
+static const struct Case {
+  const char *pattern;
+  const char *needle;
+} cases[] = {
+  { "X",                                   "X" },
+  { "X[0-9]+",                             "X1" },
+  { "XQ",                                  "XQ" },
+  { "XQ[0-9]+",                            "XQ1" },
+  { "XQZ",                                 "XQZ" },
+  { "XQZ[0-9]+",                           "XQZ1" },
+  { "XQZVW",                               "XQZVW" },
+  { "XQZVW[0-9]+",                         "XQZVW1" },
+  { "NEEDLE_IN_A_HAYSTACK",                "NEEDLE_IN_A_HAYSTACK" },
+  { "NEEDLE_IN_A_HAYSTACK[0-9]+",          "NEEDLE_IN_A_HAYSTACK1" },
+  { "Q|V",                                 "V" },
+  { "QZX|VWJ",                             "VWJ" },
+  { "Q|V|K",                               "K" },
+  { "QZX|VWJ|KPY",                         "KPY" },
+  { "QZX|VWJ|KPY|FGH",                     "FGH" },
+  { "QZX|VWJ|KPY|FGH|BDM|TNC|RLS|AEI",     "AEI" },
+  { "[A-H][A-H]",                          "HA" },
+  { "[A-Z][0-9]",                          "Z9" },
+  { "[A-M]",                               "M" },
+  { "[A-Z][A-Z]",                          "ZZ" },
+  { "[A-Z]{4}",                            "ZZZZ" },
+  { "etaoinsh",                            "etaoinsh" },
+  { "etaoinsh[0-9]+",                      "etaoinsh1" },
+  { "X.*Y",                                "XY" },
+  { "(Q|V)*J",                             "QVJ" },
+  { "(Q|V)*",                              "QV" },
+  { "(Q|V|K)*",                            "QVK" },
+  { "(Q|V|K|W)*",                          "QVKW" },
+  { "(Q|V|K|W|J)*",                        "QVKWJ" },
+  { "(Q|V|K|W|J|Z)*",                      "QVKWJZ" },
+  { "(Q|V|K|W|J|Z|X)*",                    "QVKWJZX" },
+  { "[A-H]*",                              "ABCDEFGH" },
+  { "[0-9]*",                              "0123456789" },
+  { "QZX|VWJ|KPY|FGH|BDM",                 "BDM" },
+  { "QZX|VWJ|KPY|FGH|BDM|TNC",             "TNC" },
+  { "QZX|VWJ|KPY|FGH|BDM|TNC|RLS",         "RLS" },
+};
+
+// the CPU feature levels to benchmark
+struct Level {
+  const char *name;
+  uint64_t    mask; // the reflex::HW bits to clear
+};
+
+// access the protected advance search kernel of a reflex::Matcher
+class BenchMatcher : public reflex::Matcher {
+
+ public:
+
+  typedef bool (reflex::Matcher::*Method)(size_t);
+
+  // an advance search kernel and its name
+  struct Kernel {
+    Method      method;
+    const char *name;
+  };
+
+  BenchMatcher(const reflex::Pattern& pattern)
+    :
+      reflex::Matcher(pattern)
+  { }
+
+  // the advance search kernels compiled in the matcher
+  static const Kernel *kernels(size_t& count)
+  {
+    static const Kernel methods[] = {
+#define KERNEL(method) { &BenchMatcher::method, #method }
+      KERNEL(advance_none),
+      KERNEL(advance_pattern_pin1_one),
+      KERNEL(advance_pattern_pin1_pma),
+      KERNEL(advance_pattern_pin2_one),
+      KERNEL(advance_pattern_pin2_pma),
+      KERNEL(advance_pattern_pin3_one),
+      KERNEL(advance_pattern_pin3_pma),
+      KERNEL(advance_pattern_pin4_one),
+      KERNEL(advance_pattern_pin4_pma),
+      KERNEL(advance_pattern_pin5_one),
+      KERNEL(advance_pattern_pin5_pma),
+      KERNEL(advance_pattern_pin6_one),
+      KERNEL(advance_pattern_pin6_pma),
+      KERNEL(advance_pattern_pin7_one),
+      KERNEL(advance_pattern_pin7_pma),
+      KERNEL(advance_pattern_pin8_one),
+      KERNEL(advance_pattern_pin8_pma),
+      KERNEL(advance_pattern_min1),
+      KERNEL(advance_pattern_min2),
+#if !defined(WITH_PM3_PM5)
+      KERNEL(advance_pattern_min3),
+#endif
+      KERNEL(advance_pattern_mink),
+      KERNEL(advance_char),
+#if !defined(HAVE_AVX512BW) && !defined(HAVE_AVX2) && !defined(HAVE_SSE2) && !defined(HAVE_NEON)
+      // a one char prefix followed by a pattern is only searched with this kernel without SIMD
+      KERNEL(advance_char_pma),
+#endif
+      KERNEL(advance_chars<2>),
+      KERNEL(advance_chars_pma<2>),
+      KERNEL(advance_chars<3>),
+      KERNEL(advance_chars_pma<3>),
+      KERNEL(advance_string),
+      KERNEL(advance_string_pma),
+      KERNEL(advance_string_bm),
+      KERNEL(advance_string_bm_pma),
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2)
+      KERNEL(simd_advance_pattern_pin1_pma_avx2),
+      KERNEL(simd_advance_pattern_pin2_one_avx2),
+      KERNEL(simd_advance_pattern_pin2_pma_avx2),
+      KERNEL(simd_advance_pattern_pin3_one_avx2),
+      KERNEL(simd_advance_pattern_pin3_pma_avx2),
+      KERNEL(simd_advance_pattern_pin4_one_avx2),
+      KERNEL(simd_advance_pattern_pin4_pma_avx2),
+      KERNEL(simd_advance_pattern_pin5_one_avx2),
+      KERNEL(simd_advance_pattern_pin5_pma_avx2),
+      KERNEL(simd_advance_pattern_pin6_one_avx2),
+      KERNEL(simd_advance_pattern_pin6_pma_avx2),
+      KERNEL(simd_advance_pattern_pin7_one_avx2),
+      KERNEL(simd_advance_pattern_pin7_pma_avx2),
+      KERNEL(simd_advance_pattern_pin8_one_avx2),
+      KERNEL(simd_advance_pattern_pin8_pma_avx2),
+      KERNEL(simd_advance_pattern_pin16_one_avx2),
+      KERNEL(simd_advance_pattern_pin16_pma_avx2),
+      KERNEL(simd_advance_chars_avx2<2>),
+      KERNEL(simd_advance_chars_pma_avx2<2>),
+      KERNEL(simd_advance_chars_avx2<3>),
+      KERNEL(simd_advance_chars_pma_avx2<3>),
+      KERNEL(simd_advance_string_avx2),
+      KERNEL(simd_advance_string_pma_avx2),
+#endif
+#if defined(HAVE_AVX512BW) && (!defined(_MSC_VER) || defined(_WIN64))
+      KERNEL(simd_advance_chars_avx512bw<2>),
+      KERNEL(simd_advance_chars_pma_avx512bw<2>),
+      KERNEL(simd_advance_chars_avx512bw<3>),
+      KERNEL(simd_advance_chars_pma_avx512bw<3>),
+      KERNEL(simd_advance_string_avx512bw),
+      KERNEL(simd_advance_string_pma_avx512bw),
+#endif
+#undef KERNEL
+    };
+    count = sizeof(methods) / sizeof(methods[0]);
+    return methods;
+  }
+
+  // the name of the advance search kernel selected by the matcher
+  const char *kernel() const
+  {
+#ifdef WITH_MATCHER_STATS
+    return advance_method();
+#else
+    size_t count;
+    const Kernel *methods = kernels(count);
+    for (size_t i = 0; i < count; ++i)
+      if (adv_ == methods[i].method)
+        return methods[i].name;
+    return "unknown";
+#endif
+  }
+
+};
+
+// Park-Miller minimal standard generator, the buffers are the same on all platforms
+static uint32_t seed = 1;
+
+static uint32_t rnd()
+{
+  seed = static_cast<uint32_t>(static_cast<uint64_t>(seed) * 48271 % 2147483647);
+  return seed;
+}
+
+// fill the buffer with random text of the alphabet and insert the needle density times per MB
+static void generate(std::string& buf, size_t size, const std::string& alphabet, const char *needle, size_t density)
+{
+  seed = 1;
+  buf.resize(size);
+
+  if (alphabet == "text")
+  {
+    // lowercase words of 1 to 8 letters separated by spaces with lines of about 64 bytes
+    size_t i = 0;
+    size_t col = 0;
+    while (i < size)
+    {
+      size_t n = 1 + rnd() % 8;
+      for (size_t j = 0; j < n && i < size; ++j)
+        buf[i++] = static_cast<char>('a' + rnd() % 26);
+      col += n + 1;
+      if (i < size)
+        buf[i++] = col >= 64 ? (col = 0, '\n') : ' ';
+    }
+  }
+  else if (alphabet == "dna")
+  {
+    // ACGT with lines of 60 bytes
+    static const char acgt[] = "ACGT";
+    for (size_t i = 0; i < size; ++i)
+      buf[i] = i % 61 == 60 ? '\n' : acgt[rnd() % 4];
+  }
+  else
+  {
+    // uniformly random bytes
+    for (size_t i = 0; i < size; ++i)
+      buf[i] = static_cast<char>(rnd() >> 8);
+  }
+
+  // insert the needle at random positions density times per MB
+  size_t len = strlen(needle);
+  size_t count = density * size / 1000000;
+  for (size_t k = 0; k < count && size > len; ++k)
+    memcpy(&buf[rnd() % (size - len)], needle, len);
+}
+
+// split a comma-separated list
+static std::vector<std::string> split(const char *list)
+{
+  std::vector<std::string> items;
+  const char *s = list;
+  while (true)
+  {
+    const char *e = strchr(s, ',');
+    if (e == NULL)
+    {
+      items.push_back(s);
+      break;
+    }
+    items.push_back(std::string(s, e - s));
+    s = e + 1;
+  }
+  return items;
+}
+
+// output a JSON string
+static void json_string(const char *s)
+{
+  putchar('"');
+  for (; *s != '\0'; ++s)
+  {
+    if (*s == '"' || *s == '\\')
+      putchar('\\');
+    putchar(*s);
+  }
+  putchar('"');
+}
+
+int main(int argc, char **argv)
+{
+  size_t size = 16;
+  size_t runs = 3;
+  const char *densities = "0,16,1024";
+  const char *alphabets = "text,dna,binary";
+  const char *only = NULL;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (i + 1 < argc && strcmp(argv[i], "-s") == 0)
+      size = strtoul(argv[++i], NULL, 10);
+    else if (i + 1 < argc && strcmp(argv[i], "-r") == 0)
+      runs = strtoul(argv[++i], NULL, 10);
+    else if (i + 1 < argc && strcmp(argv[i], "-d") == 0)
+      densities = argv[++i];
+    else if (i + 1 < argc && strcmp(argv[i], "-a") == 0)
+      alphabets = argv[++i];
+    else if (i + 1 < argc && strcmp(argv[i], "-k") == 0)
+      only = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: bench-advance [-s MB] [-r RUNS] [-d DENSITY,...] [-a ALPHABET,...] [-k KERNEL]\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (size == 0)
+    size = 1;
+  if (runs == 0)
+    runs = 1;
+  size *= 1000000;
+
+  // the CPU feature levels supported by this CPU, from the slowest to the fastest
+  std::vector<Level> levels;
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2) || defined(HAVE_SSE2)
+  const uint64_t hw = reflex::HW;
+  const uint64_t SSE2 = 1ULL << 26;
+  const uint64_t AVX2 = 1ULL << 37;
+  const uint64_t AVX512BW = 1ULL << 62;
+  Level none = { "none", SSE2 | AVX2 | AVX512BW };
+  levels.push_back(none);
+  Level sse2 = { "sse2", AVX2 | AVX512BW };
+  levels.push_back(sse2);
+  if (reflex::have_HW_AVX2())
+  {
+    Level avx2 = { "avx2", AVX512BW };
+    levels.push_back(avx2);
+  }
+  if (reflex::have_HW_AVX512BW())
+  {
+    Level avx512bw = { "avx512bw", 0 };
+    levels.push_back(avx512bw);
+  }
+#elif defined(HAVE_NEON)
+  Level neon = { "neon", 0 };
+  levels.push_back(neon);
+#else
+  Level none = { "none", 0 };
+  levels.push_back(none);
+#endif
+
+  std::vector<std::string> alphabet_list = split(alphabets);
+  std::vector<std::string> density_list = split(densities);
+
+  printf("{\n\"size\": %zu,\n\"runs\": %zu,\n\"features\": [", size, runs);
+  for (size_t i = 0; i < levels.size(); ++i)
+  {
+    if (i > 0)
+      printf(", ");
+    json_string(levels[i].name);
+  }
+  printf("],\n\"kernels\": [\n");
+
+  std::string buf;
+  bool first = true;
+  std::set<std::string> covered;
+
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c)
+  {
+    for (size_t a = 0; a < alphabet_list.size(); ++a)
+    {
+      for (size_t d = 0; d < density_list.size(); ++d)
+      {
+        size_t density = strtoul(density_list[d].c_str(), NULL, 10);
+        bool generated = false;
+
+        for (size_t l = 0; l < levels.size(); ++l)
+        {
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2) || defined(HAVE_SSE2)
+          // force the CPU feature level before the pattern is analyzed and the matcher selects its advance search kernel
+          reflex::HW = hw & ~levels[l].mask;
+#endif
+
+          reflex::Pattern pattern(cases[c].pattern);
+          BenchMatcher matcher(pattern);
+          const char *kernel = matcher.kernel();
+
+          if (only != NULL && strstr(kernel, only) == NULL)
+            continue;
+
+          covered.insert(kernel);
+
+          if (!generated)
+          {
+            generate(buf, size, alphabet_list[a], cases[c].needle, density);
+            generated = true;
+          }
+
+          double best = 0.0;
+          size_t matches = 0;
+
+          for (size_t r = 0; r < runs; ++r)
+          {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            // search the buffer in place, size + 1 to include the final \0
+            matcher.buffer(const_cast<char*>(buf.c_str()), buf.size() + 1);
+            matches = 0;
+            while (matcher.find() != 0)
+              ++matches;
+
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (r == 0 || seconds < best)
+              best = seconds;
+          }
+
+          if (!first)
+            printf(",\n");
+          first = false;
+
+          printf("{\"kernel\": ");
+          json_string(kernel);
+          printf(", \"feature\": ");
+          json_string(levels[l].name);
+          printf(", \"pattern\": ");
+          json_string(cases[c].pattern);
+          printf(", \"alphabet\": ");
+          json_string(alphabet_list[a].c_str());
+          printf(", \"density\": %zu, \"matches\": %zu, \"seconds\": %.6f, \"gbps\": %.3f}", density, matches, best, best > 0.0 ? size / best / 1e9 : 0.0);
+          fflush(stdout);
+        }
+      }
+    }
+  }
+
+#if defined(HAVE_AVX512BW) || defined(HAVE_AVX2) || defined(HAVE_SSE2)
+  reflex::HW = hw;
+#endif
+
+  // the kernels compiled in the matcher that no pattern selected at the CPU feature levels of this CPU
+  printf("\n],\n\"uncovered\": [");
+  size_t count;
+  const BenchMatcher::Kernel *kernels = BenchMatcher::kernels(count);
+  first = true;
+  for (size_t i = 0; i < count; ++i)
+  {
+    // advance_none is not a search kernel, it is set when the matcher has no pattern
+    if (strcmp(kernels[i].name, "advance_none") == 0)
+      continue;
+
+    if ((only == NULL || strstr(kernels[i].name, only) != NULL) && covered.find(kernels[i].name) == covered.end())
+    {
+      if (!first)
+        printf(", ");
+      first = false;
+      json_string(kernels[i].name);
+    }
+  }
+  printf("]\n}\n");
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,290 @@
+#!/bin/bash
+
+# Benchmark ugrep on deterministic synthetic corpora and output the results in JSON
+#
+# Usage:
+#
+#   bench.sh [OPTIONS]                 run the benchmarks with optional ugrep OPTIONS, e.g. -J1
+#   bench.sh --compare OLD.json NEW.json
+#                                      compare the results of two runs
+#
+# Environment variables:
+#
+#   BENCH_SCALE  corpus size multiplier, default 1 (about 100MB of corpora)
+#   BENCH_RUNS   number of runs per search, the fastest run is reported, default 3
+#   BENCH_DIR    directory to hold the generated corpora, default $TMPDIR/ugrep-bench-$BENCH_SCALE
+
+UGREP=${UGREP_ABS_PATH:-../src/ugrep}
+UGREP_INDEXER=${UGREP_INDEXER_ABS_PATH:-../src/ugrep-indexer}
+CONFIGH=${CONFIGH_ABS_PATH:-../config.h}
+
+SCALE=${BENCH_SCALE:-1}
+RUNS=${BENCH_RUNS:-3}
+DIR=${BENCH_DIR:-${TMPDIR:-/tmp}/ugrep-bench-$SCALE}
+
+# the corpus generator version, corpora are regenerated when the generator changes
+CORPUS="bench corpus 1 scale $SCALE"
+
+# compare two runs
+
+if test "$1" = "--compare" ; then
+  if test $# -ne 3 ; then
+    echo "usage: bench.sh --compare OLD.json NEW.json"
+    exit 1
+  fi
+  awk '
+    function field(line, key,    s) {
+      s = line
+      if (!sub(".*\"" key "\": *", "", s))
+        return ""
+      sub("^\"", "", s)
+      sub("[\",}].*", "", s)
+      return s
+    }
+    /"startup_seconds"/ { startup[FILENAME == ARGV[1]] = field($0, "startup_seconds") }
+    /"name":/ {
+      name = field($0, "name")
+      if (FILENAME == ARGV[1]) {
+        old[name] = field($0, "seconds")
+      } else {
+        order[++n] = name
+        new[name] = field($0, "seconds")
+      }
+    }
+    END {
+      printf "%-24s %12s %12s %8s\n", "search", "old (s)", "new (s)", "speedup"
+      if (startup[1] > 0 && startup[0] > 0)
+        printf "%-24s %12.6f %12.6f %7.2fx\n", "startup", startup[1], startup[0], startup[1] / startup[0]
+      for (i = 1; i <= n; ++i) {
+        name = order[i]
+        if (name in old && old[name] > 0 && new[name] > 0)
+          printf "%-24s %12.6f %12.6f %7.2fx\n", name, old[name], new[name], old[name] / new[name]
+        else
+          printf "%-24s %12s %12s %8s\n", name, (name in old ? old[name] : "-"), new[name], "-"
+      }
+    }' "$2" "$3"
+  exit $?
+fi
+
+# check for errors in the installation
+
+if test ! -x "$UGREP" ; then
+  echo "$UGREP not found, exiting" >&2
+  exit 1
+fi
+
+if test ! -e "$CONFIGH" ; then
+  echo "$CONFIGH not found, exiting" >&2
+  exit 1
+fi
+
+if $UGREP -Fq 'HAVE_PCRE2 1' "$CONFIGH" || $UGREP -Fq 'HAVE_BOOST_REGEX 1' "$CONFIGH" ; then
+  have_perl=yes
+else
+  have_perl=no
+fi
+
+if $UGREP -Fq 'HAVE_LIBZ 1' "$CONFIGH" ; then
+  have_libz=yes
+else
+  have_libz=no
+fi
+
+# a clock with nanosecond resolution
+
+if test "$(date +%N)" != "%N" && test "$(date +%N)" != "N" ; then
+  now() { date +%s%N; }
+elif perl -MTime::HiRes -e 1 2> /dev/null ; then
+  now() { perl -MTime::HiRes=time -e 'printf "%.0f\n", time * 1e9'; }
+else
+  echo "date +%N or perl Time::HiRes is required to time searches, exiting" >&2
+  exit 1
+fi
+
+# generate the corpora once, the corpora are deterministic
+
+if test "$(cat "$DIR/.corpus" 2> /dev/null)" != "$CORPUS" ; then
+  echo "generating corpora in $DIR" >&2
+
+  rm -rf "$DIR"
+  mkdir -p "$DIR/src" || exit 1
+
+  # pseudo-random numbers with the Park-Miller generator, exact in awk double precision arithmetic
+  RAND='
+    function rnd(n) { seed = (seed * 16807) % 2147483647; return seed % n }
+    function word(    w, k, i) {
+      k = 2 + rnd(3)
+      w = ""
+      for (i = 0; i < k; ++i)
+        w = w syl[1 + rnd(nsyl)]
+      return w
+    }
+    BEGIN {
+      nsyl = split("ba ke ri to mu na lo pe si da vo gu ze fi ha ny co tr st en al or un ex", syl, " ")
+    }
+  '
+
+  # log files
+  awk -v n=$((SCALE * 400000)) "$RAND"'
+    BEGIN {
+      seed = 1
+      nlvl = split("INFO INFO INFO INFO INFO DEBUG DEBUG WARN ERROR", lvl, " ")
+      nmth = split("GET GET GET POST PUT DELETE", mth, " ")
+      nres = split("users items orders search login health metrics", res, " ")
+      nmsg = split("ok|ok|ok|cache hit|cache miss|connection refused|timeout after 30s|retrying request", msg, "|")
+      for (i = 0; i < n; ++i)
+        printf "2024-%02d-%02d %02d:%02d:%02d %s [worker-%d] %s /api/v1/%s?id=%d&q=%s status=%d latency=%dms %s\n",
+          1 + rnd(12), 1 + rnd(28), rnd(24), rnd(60), rnd(60), lvl[1 + rnd(nlvl)], rnd(64), mth[1 + rnd(nmth)],
+          res[1 + rnd(nres)], rnd(1000000), word(), rnd(50) ? 200 : 500 + rnd(4), rnd(2000), msg[1 + rnd(nmsg)]
+    }' > "$DIR/logs.txt"
+
+  # source code tree
+  for d in $(seq 1 $((SCALE * 40))) ; do
+    mkdir -p "$DIR/src/module$d/include" "$DIR/src/module$d/lib"
+  done
+  awk -v dirs=$((SCALE * 40)) -v dir="$DIR/src" "$RAND"'
+    BEGIN {
+      seed = 2
+      next_ext = split("c h cpp hpp py js md", ext, " ")
+      ntyp = split("int size_t char* bool double void", typ, " ")
+      for (d = 1; d <= dirs; ++d) {
+        for (f = 1; f <= 50; ++f) {
+          e = ext[1 + rnd(next_ext)]
+          path = dir "/module" d "/" (e ~ /^h/ ? "include" : "lib") "/" word() "_" f "." e
+          for (fn = 0; fn < 5 + rnd(20); ++fn) {
+            name = word() "_" word()
+            printf "/* %s %s %s */\n%s %s(%s %s, %s %s)\n{\n", word(), word(), word(), typ[1 + rnd(ntyp)], name, typ[1 + rnd(ntyp)], word(), typ[1 + rnd(ntyp)], word() >> path
+            for (s = 0; s < 3 + rnd(12); ++s)
+              printf "  %s = %s(%s, %d); // %s %s\n", word(), word(), word(), rnd(1000), word(), word() >> path
+            printf "  return %s;\n}\n\n", word() >> path
+          }
+          close(path)
+        }
+      }
+    }'
+
+  # word list for -f
+  awk "$RAND"'
+    BEGIN {
+      seed = 3
+      for (i = 0; i < 200; ++i)
+        print word() word()
+    }' > "$DIR/words.txt"
+
+  # long-line JSON
+  awk -v n=$((SCALE * 16)) "$RAND"'
+    BEGIN {
+      seed = 4
+      for (i = 0; i < n; ++i) {
+        printf "["
+        for (j = 0; j < 10000; ++j)
+          printf "%s{\"id\":%d,\"name\":\"%s\",\"tags\":[\"%s\",\"%s\"],\"score\":%d.%02d,\"active\":%s}", j ? "," : "", rnd(1000000), word(), word(), word(), rnd(100), rnd(100), rnd(2) ? "true" : "false"
+        printf "]\n"
+      }
+    }' > "$DIR/long.json"
+
+  # UTF-16 text
+  if command -v iconv > /dev/null ; then
+    head -n $((SCALE * 100000)) "$DIR/logs.txt" | iconv -f UTF-8 -t UTF-16 > "$DIR/text.utf16"
+  fi
+
+  # compressed archives
+  if command -v gzip > /dev/null ; then
+    (cd "$DIR" && tar cf - src | gzip -n > src.tar.gz)
+    gzip -n -c "$DIR/logs.txt" > "$DIR/logs.txt.gz"
+  fi
+
+  # indexed copy of the source code tree
+  if test -x "$UGREP_INDEXER" ; then
+    mkdir -p "$DIR/idx" && cp -R "$DIR/src" "$DIR/idx/" && "$UGREP_INDEXER" -q "$DIR/idx" > /dev/null
+  fi
+
+  echo "$CORPUS" > "$DIR/.corpus"
+fi
+
+# the total size of the files of a corpus in bytes
+
+size() {
+  find "$DIR/$1" -type f ! -name '._UG#_Store' -exec cat {} + 2> /dev/null | wc -c | tr -d ' '
+}
+
+# JSON string
+
+json() {
+  printf '"%s"' "$(printf '%s' "$1" | sed -e 's/\\/\\\\/g' -e 's/"/\\"/g')"
+}
+
+# time the fastest of RUNS runs in nanoseconds, output is saved to a file because ugrep stops early when output is sent to /dev/null
+
+fastest() {
+  local best= t0 t1 dt r
+  for r in $(seq 1 $RUNS) ; do
+    t0=$(now)
+    "$UGREP" "$@" > "$DIR/.out" 2> /dev/null
+    t1=$(now)
+    dt=$((t1 - t0))
+    if test -z "$best" || test $dt -lt $best ; then
+      best=$dt
+    fi
+  done
+  echo $best
+}
+
+# run a search on a corpus: NAME CORPUS ARGS...
+
+sep=""
+
+search() {
+  local name=$1 corpus=$2 bytes ns out status
+  shift 2
+  test -e "$DIR/$corpus" || return
+  echo "  $name" >&2
+  bytes=$(size "$corpus")
+  (cd "$DIR" && "$UGREP" "$@" $OPTIONS "$corpus" > "$DIR/.out" 2> /dev/null)
+  status=$?
+  out=$(wc -c < "$DIR/.out" | tr -d ' ')
+  ns=$(cd "$DIR" && fastest "$@" $OPTIONS "$corpus")
+  printf '%s\n    {"name": %s, "args": %s, "corpus": %s, "bytes": %s, "seconds": %s, "mb_per_second": %s, "output_bytes": %s, "status": %s}' \
+    "$sep" "$(json "$name")" "$(json "$*")" "$(json "$corpus")" $bytes \
+    $(awk -v ns=$ns -v b=$bytes 'BEGIN { printf "%.6f %.1f", ns / 1e9, (ns > 0 ? b / (ns / 1e3) : 0) }') \
+    $out $status
+  sep=","
+}
+
+OPTIONS="$*"
+
+echo "running benchmarks" >&2
+
+startup=$(fastest -q ugrep /dev/null)
+startup=$(awk -v ns=$startup 'BEGIN { printf "%.6f", ns / 1e9 }')
+
+printf '{\n  "version": %s,\n  "options": %s,\n  "corpus": %s,\n  "runs": %s,\n  "startup_seconds": %s,\n  "searches": [' \
+  "$(json "$("$UGREP" --version | head -n1)")" "$(json "$OPTIONS")" "$(json "$CORPUS")" $RUNS $startup
+
+search literal          logs.txt      -c ERROR
+search ignore-case      logs.txt      -c -i 'connection refused'
+search word             logs.txt      -c -w GET
+search alternation      logs.txt      -c 'ERROR|WARN|timeout|refused'
+search regex            logs.txt      -c 'status=5[0-9][0-9] latency=1[0-9]{3}ms'
+search word-list        logs.txt      -c -F -f words.txt
+search fuzzy            logs.txt      -c -Z2 'conection refusd'
+test "$have_perl" = "yes" && \
+search perl             logs.txt      -c -P '(?<=status=)5\d\d'
+search bool             logs.txt      -c --bool 'ERROR -timeout'
+search only-matching    logs.txt      -o 'latency=[0-9]+ms'
+search lines            logs.txt      -n 'WARN.*retrying'
+search long-lines       long.json     -c '"score":99\.99'
+search long-lines-only  long.json     -o '"name":"[a-z]+"'
+search utf16            text.utf16    -c 'cache miss'
+search recursive        src           -rl 'return kefi'
+search recursive-types  src           -rl -tc,c++ 'int [a-z]+_[a-z]+\('
+search recursive-count  src           -rc --include='*.py' 'TODO|FIXME|ba[a-z]*'
+test "$have_libz" = "yes" && \
+search decompress       logs.txt.gz   -z -c ERROR
+test "$have_libz" = "yes" && \
+search archive          src.tar.gz    -z -l 'return kefi'
+search index            idx           -rl --index 'return kefi'
+
+rm -f "$DIR/.out"
+
+printf '\n  ]\n}\n'
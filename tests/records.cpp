@@ -0,0 +1,85 @@
+/******************************************************************************\
+* Copyright (c) 2019, Robert van Engelen, Genivia Inc. All rights reserved.    *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+*   (1) Redistributions of source code must retain the above copyright notice, *
+*       this list of conditions and the following disclaimer.                  *
+*                                                                              *
+*   (2) Redistributions in binary form must reproduce the above copyright      *
+*       notice, this list of conditions and the following disclaimer in the    *
+*       documentation and/or other materials provided with the distribution.   *
+*                                                                              *
+*   (3) The name of the author may not be used to endorse or promote products  *
+*       derived from this software without specific prior written permission.  *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED *
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF         *
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO   *
+* EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,       *
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, *
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;  *
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,     *
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR      *
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF       *
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                                   *
+\******************************************************************************/
+
+
+/**
+@file      records.cpp
+@brief     print the --records binary records read from standard input as text
+@author    Robert van Engelen - engelen@genivia.com
+@copyright (c) 2019-2025, Robert van Engelen, Genivia Inc. All rights reserved.
+@copyright (c) BSD-3 License - see LICENSE.txt
+
+Reads the records with the reference reader RecordReader of src/records.hpp and
+prints one line per record, used by verify.sh to test option --records.  Exits
+with status 1 when the input is truncated or malformed.
+*/
+
+#include "records.hpp"
+
+int main()
+{
+  RecordReader reader(stdin);
+  RecordReader::Record record;
+
+  while (reader.next(record))
+  {
+    switch (record.type)
+    {
+      case RecordReader::HEADER:
+        printf("H %llu\n", static_cast<unsigned long long>(record.count));
+        break;
+
+      case RecordReader::PATHNAME:
+        printf("F %llu %s {%s}\n", static_cast<unsigned long long>(record.id), reader.pathname(record.id).c_str(), reader.partname(record.id).c_str());
+        break;
+
+      case RecordReader::MATCH:
+      case RecordReader::LINE:
+        printf("%c %s:%llu:%llu:%llu:%llu:%llu:", record.type, reader.pathname(record.id).c_str(), static_cast<unsigned long long>(record.lineno), static_cast<unsigned long long>(record.columno), static_cast<unsigned long long>(record.offset), static_cast<unsigned long long>(record.size), static_cast<unsigned long long>(record.text_offset));
+        fwrite(record.text, 1, record.text_size, stdout);
+        putchar('\n');
+        break;
+
+      case RecordReader::COUNT:
+        printf("C %s:%llu\n", reader.pathname(record.id).c_str(), static_cast<unsigned long long>(record.count));
+        break;
+
+      case RecordReader::END:
+        printf("E %llu\n", static_cast<unsigned long long>(record.count));
+        break;
+    }
+  }
+
+  if (reader.error())
+  {
+    fprintf(stderr, "records: truncated or malformed input\n");
+    return 1;
+  }
+
+  return 0;
+}
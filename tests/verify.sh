@@ -2,6 +2,7 @@
 
 UGREP=${UGREP_ABS_PATH:-../src/ugrep}
 CONFIGH=${CONFIGH_ABS_PATH:-../config.h}
+RECORDS=${RECORDS_ABS_PATH:-../tests/records}
 
 UG="$UGREP --color=always --sort $@"
 
@@ -189,6 +190,96 @@ $UG -Rl --ignore-files                   Hello dir1 | $DIFF out/dir--ignore-file
 printf .
 $UG -Rl --filter='sh:head -n1'           Hello dir1 | $DIFF out/dir--filter.out       || ERR "-Rl --filter='sh:head -n1' Hello dir1"
 
+if perl -e 1 2> /dev/null ; then
+cat > coprocess.pl << 'END'
+# --filter coprocess responds with the first line of each file received
+binmode STDIN;
+binmode STDOUT;
+$| = 1;
+while (read(STDIN, $head, 8) == 8) {
+  my ($lo, $hi) = unpack("VV", $head);
+  my $data = '';
+  read(STDIN, $data, $lo + $hi * 4294967296);
+  my ($line) = $data =~ /\A([^\n]*\n?)/;
+  print pack("VV", length($line), 0), $line;
+}
+END
+printf .
+$UG -Rl --filter='sh:|perl coprocess.pl' Hello dir1 | $DIFF out/dir--filter.out       || ERR "-Rl --filter='sh:|perl coprocess.pl' Hello dir1"
+rm -f coprocess.pl
+fi
+
+for ORDER in inode extent size ; do
+printf .
+$UGREP --color=always $@ -rl --read-order=$ORDER Hello dir1 | LC_ALL=C sort | $DIFF out/dir.out || ERR "-rl --read-order=$ORDER Hello dir1"
+done
+printf .
+$UGREP --read-order=inode --stats -rl Hello dir1 | grep '^Read' | $DIFF out/dir--read-order-stats.out || ERR "--read-order=inode --stats -rl Hello dir1"
+
+# --cache skips files that did not match before, the files must be older than CACHE_RACY_TIME to be cached
+rm -rf dir3 cache.dat
+mkdir -p dir3
+cp Hello.sh Hello.bat makefile dir3
+echo 'Hello' > dir3/hello.txt
+echo 'Bye' > dir3/bye.txt
+echo 'Bye' > dir3/gone.txt
+sleep 3
+printf .
+$UG -Rl --cache=cache.dat            Hello dir3 | $DIFF out/dir--cache.out        || ERR "-Rl --cache=cache.dat Hello dir3"
+printf .
+$UGREP -Rl --cache=cache.dat --stats Hello dir3 | grep '^Skipped' | $DIFF out/dir--cache-stats.out  || ERR "-Rl --cache=cache.dat --stats Hello dir3"
+echo 'Hello' >> dir3/bye.txt
+rm -f dir3/gone.txt
+printf .
+$UG -Rl --cache=cache.dat            Hello dir3 | $DIFF out/dir--cache-changed.out || ERR "-Rl --cache=cache.dat Hello dir3 after changing dir3/bye.txt"
+SIZE=`wc -c < cache.dat`
+$UG -Rl --cache=cache.dat Hello dir3 > /dev/null
+$UG -Rl --cache=cache.dat Hello dir3 > /dev/null
+$UG -Rl --cache=cache.dat Hello dir3 > /dev/null
+printf .
+test `wc -c < cache.dat` -lt $SIZE || ERR "-Rl --cache=cache.dat Hello dir3 did not drop dir3/gone.txt"
+rm -rf dir3 cache.dat
+
+printf .
+rm -rf dir4
+mkdir -p dir4
+cat > dir4/.gitignore << 'END'
+*.o
+*.a
+*.so
+*.class
+*.pyc
+*.tmp
+*~
+*.swp
+*.bak
+*.log
+!keep[0-9].log
+*.[ch]
+!main.c
+**/cache/**
+!**/cache/readme
+build/
+/d[0-9]/f*[02468].txt
+!/d[0-9]/f1[0-9]0.txt
+*.dat
+END
+EXT=(o a tmp log c h txt dat)
+for D in d0 d1 d2 d3 d4 ; do
+  mkdir -p dir4/$D/cache dir4/$D/build
+  for (( I = 0; I < 1000; ++I )) ; do
+    echo Hello > dir4/$D/f$I.${EXT[I % 8]}
+  done
+  echo Hello > dir4/$D/keep1.log
+  echo Hello > dir4/$D/main.c
+  echo Hello > dir4/$D/cache/readme
+  echo Hello > dir4/$D/cache/notes.txt
+  echo Hello > dir4/$D/build/out.txt
+done
+# more than GLOBS_COMPILE_COUNT pathnames are matched against the .gitignore globs, which are then compiled into DFAs
+$UG -Rl --ignore-files Hello dir4 | $DIFF out/dir--ignore-files-dfa.out || ERR "-Rl --ignore-files Hello dir4"
+rm -rf dir4
+
 rm -rf dir1 dir2
 
 fi
@@ -268,6 +359,33 @@ printf .
 $UG --range=1,1   Hello $FILES \
     | $DIFF out/Hello_Hello--range.out \
     || ERR "--range=1,1 Hello $FILES"
+printf .
+$UG --drop-cache -ci hello $FILES \
+    | $DIFF out/Hello_Hello-ci.out \
+    || ERR "--drop-cache -ci hello $FILES"
+printf .
+$UGREP --drop-cache --stats -c Hello $FILES | grep '^Read' | sed -e 's/ at .*//' \
+    | $DIFF out/Hello_Hello--drop-cache-stats.out \
+    || ERR "--drop-cache --stats -c Hello $FILES"
+printf .
+$UGREP --stats -c Hello $FILES | grep '^Read' \
+    && ERR "--stats -c Hello $FILES reports the bytes read without --drop-cache"
+printf .
+$UG -U --sort-buffer=1 -n Hello $FILES \
+    | $DIFF out/Hello_Hello-n.out \
+    || ERR "--sort-buffer=1 -n Hello $FILES"
+printf .
+$UG -rn Hello out > sort-buffer.out
+$UG -rn --sort-buffer=1 Hello out | $DIFF sort-buffer.out || ERR "-rn --sort-buffer=1 Hello out"
+rm -f sort-buffer.out
+
+printf .
+seq 1 60000 > mmap.txt
+for OPS in '-nb 1.*9$' '-nbo 99\n1' '-c 7' ; do
+  $UG --no-mmap $OPS mmap.txt > mmap.out
+  $UG --mmap=16384 $OPS mmap.txt | $DIFF mmap.out || ERR "--mmap=16384 $OPS mmap.txt"
+done
+rm -f mmap.txt mmap.out
 
 for PAT in '' 'Hello' '\w+[\n\h]+\S+' '\S\n\S' 'nomatch' ; do
   FN=`echo "Hello_$PAT" | tr -Cd '[:alnum:]_'`
@@ -503,6 +621,21 @@ for PAT in '\.' 'et' 'hendrerit' 'aliquam' 'sit amet aliquam' 'Nunc hendrerit at
 done
 fi
 
+if test -x "$RECORDS" ; then
+printf .
+$UG --records -n -I Hello $FILES       | "$RECORDS" | $DIFF out/Hello_Hello--records.out       || ERR "--records -n -I Hello $FILES"
+printf .
+$UG --records=spans -o -I Hello $FILES | "$RECORDS" | $DIFF out/Hello_Hello--records-spans.out || ERR "--records=spans -o -I Hello $FILES"
+printf .
+$UG --records -c Hello $FILES          | "$RECORDS" | $DIFF out/Hello_Hello--records-c.out     || ERR "--records -c Hello $FILES"
+printf .
+printf 'F\030\000\000\000\000\000\000\377\377\377\377\377\377\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000' \
+  | "$RECORDS" 2> /dev/null && ERR "--records with a file id out of range accepted by src/records.hpp"
+printf .
+printf 'M\377\377\377\377\377\377\000' \
+  | "$RECORDS" 2> /dev/null && ERR "--records with a payload size out of range accepted by src/records.hpp"
+fi
+
 # optional: verify SIMD, PM-4, Bitap, and Bloom filter optimizations
 # a=
 # for (( i = 1; i <= 8; ++i )); do